@@ -2,13 +2,18 @@
  * AST.h
  * 抽象语法树
  *
+ * 结点从当前的 Arena 中分配，子结点数组内嵌在结点中，
+ * 不再使用的子树不单独释放，编译结束时随内存池一起回收。
+ * 结点按语法分析的顺序连续分配，语句类型、表达式类型和属性各占一个字节，
+ * 指针字段在前，整个结点不超过一条缓存行(64字节)。
  */
 #ifndef __AST_H__
 #define __AST_H__
 
 #include "Token.h"
+#include "Arena.h"
 
-enum class StmtType
+enum class StmtType : int8_t
 {
     /* 语句类型 */
     INVALID = -1,
@@ -41,9 +46,11 @@ enum class StmtType
     RET_STMT,    //返回语句
     ASSIGN_STMT, //赋值语句
     COMP_STMT,   //复合语句
+
+    ARR_SIZE, // 数组长度，由优化过程生成
 };
 
-enum class ExpType
+enum class ExpType : int8_t
 {
     /* 表达式返回值类型 */
     INVALID = -1,
@@ -67,29 +74,38 @@ class ASTNode
      * child 子女结点，执行语句构成部分
      */
 public:
+    inline static const int MAXCHILD{3};
+    ASTNodePointer sibling{nullptr};    // 同级语句
+    ASTNodePointer child[MAXCHILD]{};   // 语句构成
+    SymNodePointer symbol_ptr{nullptr}; // 符号表结点
     Token token;                        // 单词
     StmtType stmtType{StmtType::NONE};  //语句类型
     ExpType expType{ExpType::NONE};     // 表达式类型
-    ASTNodePointer sibling{nullptr};    // 同级语句
-    ASTNodePointer *child{nullptr};     // 语句构成
-    SymNodePointer symbol_ptr{nullptr}; // 符号表结点
-    inline static const int MAXCHILD{3};
+    uint8_t attr{0};                    // 优化分析得到的属性
+
+    // 属性标记
+    inline static const int ATTR_LOW_SAFE{0x1};  // 数组下标已证明非负
+    inline static const int ATTR_HIGH_SAFE{0x2}; // 数组下标已证明小于数组长度
+    inline static const int ATTR_NONNEG{0x4};    // 除法的被除数已证明非负
 
 private:
-    int childIdx{0};
+    int8_t childIdx{0};
 
 public:
     ASTNode();
     ASTNode(Token tk);
     ASTNode(StmtType st);
     ASTNode(Token tk, StmtType st);
-    ~ASTNode();
-    void InitChild();                     // 初始化子结点数组
-    void AddSibling(ASTNodePointer node); // 添加同级语句到末尾
+    static void *operator new(size_t size); // 从当前内存池分配
+    static void operator delete(void *ptr); // 由内存池整体释放
+    void AddSibling(ASTNodePointer node); // 添加同级语句到末尾，需要遍历整个链表
+    static void Append(ASTNodePointer &head, ASTNodePointer &tail, ASTNodePointer node); // 添加到 head...tail 的末尾，O(1)
     void AddChild(ASTNodePointer node);   // 添加子结点
     void AddChild(Token tk, StmtType st);
     bool IsTypeOf(const StmtType &st); // 语句类型判断  ==
     bool IsTypeOf(const ExpType &et);  // 表达式类型判断 ==
+    bool HasAttr(int a);               // 属性判断
+    ASTNodePointer Clone();            // 深拷贝子树，不包括自身的兄弟结点
 };
 
 class AST
@@ -104,15 +120,21 @@ public:
 private:
     inline static const int INDENT{4};
 
+    struct Line
+    {
+        ASTNodePointer node; // 待打印的结点
+        int indent;          // 缩进
+        const char *title;   // 非空时打印一行标题
+    };
+
 public:
     AST() = default;
-    ~AST();
     void PrintTree();
     string ToString();
 
 private:
     void ToString(ASTNodePointer subTree, string &buf, int indent);
-    void Destroy(ASTNodePointer tree);
+    void ToString(ASTNodePointer subTree, string &buf, int indent, vector<Line> &stack); // 打印结点本身，之后的内容按顺序压栈
 };
 
 #endif
\ No newline at end of file
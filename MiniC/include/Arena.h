@@ -0,0 +1,63 @@
+/**
+ * Arena.h
+ * 一次编译使用的内存池
+ *
+ * 语法树结点和符号结点从成块的内存中依次分配，分配只移动指针，单个结点不释放，
+ * 编译结束时整体释放。需要析构的对象分配时登记析构函数，释放时按分配的逆序调用。
+ * 释放后保留第一块内存供下一次编译使用。
+ * Arena::Scope 在其生存期内把指定的内存池设为当前内存池，没有设置时使用进程级的内存池。
+ */
+
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+using std::pair;
+using std::vector;
+
+class Arena
+{
+public:
+    using Destructor = void (*)(void *);
+
+    class Scope
+    {
+        // 在生存期内设置当前内存池
+    private:
+        Arena *saved{nullptr};
+
+    public:
+        explicit Scope(Arena &arena);
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+    };
+
+private:
+    inline static const size_t BLOCK{64 * 1024}; // 每块内存的大小，更大的对象单独成块
+    inline static Arena *current{nullptr};       // 当前内存池
+
+    vector<pair<char *, size_t>> blocks;        // 已申请的内存块及其大小
+    char *cur{nullptr};                         // 当前块中下一个可用的位置
+    char *end{nullptr};                         // 当前块的末尾
+    vector<pair<Destructor, void *>> destructs; // 释放时需要析构的对象
+    size_t used{0};                             // 已分配的字节数
+
+public:
+    Arena() = default;
+    ~Arena();
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    void *Alloc(size_t size, size_t align, Destructor destruct = nullptr); // 分配内存，destruct 非空时释放前调用
+    void Release();                                                        // 析构登记的对象，释放全部内存
+    size_t Used() const;                                                   // 已分配的字节数
+    static Arena &Current();                                               // 当前内存池
+
+private:
+    void Grow(size_t size); // 申请至少 size 字节的新块
+};
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * BoundsCheck.h
+ * 数组越界检查消除
+ *
+ * 在语法树上对局部整型变量做区间分析，下标已证明不越界的数组访问不再生成检查指令。
+ * 对 while (i < n) { ... i = i + c; } 形式的计数循环做循环版本化：
+ * 在循环前一次性检查 i 的初值和 n，条件满足时执行不带检查的循环副本，否则执行原循环。
+ */
+
+#ifndef __BOUNDSCHECK_H__
+#define __BOUNDSCHECK_H__
+
+#include <map>
+#include <vector>
+#include "AST.h"
+#include "SymTable.h"
+#include "IR.h"
+
+using std::map;
+using std::vector;
+
+class Interval
+{
+    /**
+     * 整数区间 [lo, hi]，超出int范围的运算结果视为未知
+     */
+public:
+    long long lo;
+    long long hi;
+
+public:
+    Interval();
+    Interval(long long l, long long h) : lo(l), hi(h) {}
+    bool IsTop() const;
+    bool IsEmpty() const { return lo > hi; }
+    bool operator==(const Interval &o) const { return lo == o.lo && hi == o.hi; }
+    static Interval Fit(long long l, long long h); // 溢出时返回未知区间
+};
+
+class RangeState
+{
+    /**
+     * 程序点上各变量的取值区间，没有记录的变量取值未知
+     */
+public:
+    bool dead{false}; // 不可达
+    map<SymNodePointer, Interval> vars;
+
+public:
+    Interval Get(SymNodePointer sym) const;
+    void Set(SymNodePointer sym, const Interval &v);
+    bool operator==(const RangeState &o) const { return dead == o.dead && vars == o.vars; }
+    static RangeState Join(const RangeState &a, const RangeState &b);  // 合并两条路径
+    static RangeState Widen(const RangeState &a, const RangeState &b); // 加宽，保证循环分析收敛
+};
+
+class BoundsCheck
+{
+public:
+    int mode{IR::BOUNDS_NEG}; // 越界检查级别
+    int versioned{0};         // 版本化的循环数
+
+private:
+    inline static const int WIDEN_AFTER{2}; // 迭代若干次后开始加宽
+    inline static const int MAX_ITER{32};
+
+public:
+    BoundsCheck() = default;
+    void Run(AST &ast); // 分析并标记语法树
+
+private:
+    void Stmt(ASTNodePointer subTree, RangeState &st, bool annotate);
+    void StmtList(ASTNodePointer list, RangeState &st, bool annotate);
+    void Loop(ASTNodePointer subTree, RangeState &st, bool annotate);
+    Interval Eval(ASTNodePointer subTree, RangeState &st, bool annotate);
+    void Refine(ASTNodePointer cond, RangeState &st, bool truth); // 根据条件的真假缩小区间
+    void Restrict(RangeState &st, SymNodePointer sym, TokenType op, const Interval &r);
+    void Annotate(ASTNodePointer subTree, const Interval &idx, const RangeState &st);
+    int NeedCheck(ASTNodePointer subTree); // 数组访问仍然需要的检查
+
+    bool Version(ASTNodePointer loop, const RangeState &entry); // 循环版本化
+    bool IndexOffset(ASTNodePointer idx, SymNodePointer var, long long &d);
+    void CollectAccess(ASTNodePointer subTree, vector<ASTNodePointer> &access);
+    int CountAssign(ASTNodePointer subTree, SymNodePointer sym);
+    ASTNodePointer MakeNum(const Token &tk, long long v);
+    ASTNodePointer MakeOp(const Token &tk, StmtType st, TokenType op, ASTNodePointer l, ASTNodePointer r);
+
+    static bool IsTracked(SymNodePointer sym); // 是否参与分析的标量变量
+    static bool IsPure(ASTNodePointer subTree); // 表达式没有副作用
+};
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * BuiltIn.h
+ * 直接翻译为虚拟机指令的内建函数
+ *
+ * 数组实参传入基址，最后一个整型参数是元素个数，执行时放在 AC 中。
+ * 有返回值的指令结果写回 AC，其余实参依次装入 r,s,t 使用的寄存器。
+ * 名字以下划线开头的只由优化过程生成(源程序的标识符只含字母)，
+ * 它们倒数第二个参数是各数组共同的起始下标，加到每个数组的基址上。
+ * 其余的是源程序可以调用的数组库函数，例如 arrsort(a, n)、arrfind(a, v, n)，
+ * 开启完整越界检查时元素个数不能超过各数组的长度。
+ */
+
+#ifndef __BUILTIN_H__
+#define __BUILTIN_H__
+
+#include <string>
+#include <vector>
+#include "SymTable.h"
+
+using std::string;
+using std::vector;
+
+class BuiltIn
+{
+public:
+    string name;   // 函数名
+    SymType rtype; // 返回值类型
+    string params; // 参数类型，每个字符是一个 SymType
+    string op;     // 虚拟机指令
+    bool offset;   // 倒数第二个参数是起始下标
+
+    static const vector<BuiltIn> TABLE;
+
+public:
+    bool HasResult() const;                      // 有返回值
+    static const BuiltIn *Find(SymNodePointer sym); // 按函数符号查找，不是这类内建函数时返回nullptr
+    static const BuiltIn *FindOp(const string &op); // 按虚拟机指令查找
+};
+
+#endif
@@ -0,0 +1,83 @@
+/**
+ * CFG.h
+ * 控制流图和调用图
+ *
+ * 在四元式序列上划分基本块，建立块间的前驱/后继关系，
+ * 并根据函数调用指令建立调用图。
+ * 不可达基本块、未被调用的函数和其他分析标记删除的指令会被删除，删除后重新排布指令并修正跳转偏移。
+ */
+
+#ifndef __CFG_H__
+#define __CFG_H__
+
+#include <vector>
+#include <string>
+#include "IR.h"
+
+using std::string;
+using std::vector;
+
+class BasicBlock
+{
+    /**
+     * 基本块
+     * 指令区间 [begin, end)
+     */
+public:
+    int id{0};             // 编号
+    int begin{0};          // 第一条指令的位置
+    int end{0};            // 最后一条指令的下一个位置
+    int func{-1};          // 所属函数的编号
+    bool reachable{false}; // 可达标记
+    vector<int> succ;      // 后继基本块
+    vector<int> pred;      // 前驱基本块
+
+public:
+    int Last() const { return end - 1; } // 最后一条指令的位置
+};
+
+class CFGFunc
+{
+    /**
+     * 调用图结点
+     * 启动代码作为名为 _start 的函数处理
+     */
+public:
+    string name;           // 函数名
+    int entry{0};          // 入口指令的位置
+    int end{0};            // 函数代码结束位置
+    int block{-1};         // 入口基本块
+    bool reachable{false}; // 是否会被调用
+    vector<int> blocks;    // 函数内的基本块
+    vector<int> callees;   // 调用的函数
+    vector<int> callers;   // 调用者
+};
+
+class CFG
+{
+public:
+    vector<BasicBlock> blocks; // 基本块
+    vector<CFGFunc> funcs;     // 调用图
+    vector<int> target;        // 每条指令的跳转目标(绝对位置)，-1表示没有
+    vector<int> blockOf;       // 每条指令所在的基本块
+    vector<bool> removed;      // 被删除的指令，由 Linearize 移除
+
+private:
+    inline static const int INDENT{4};
+    IR *ir{nullptr};
+
+public:
+    CFG() = default;
+    void Build(IR &ir);         // 在四元式上建立控制流图和调用图
+    int RemoveUnreachable();    // 删除不可达的基本块和未被调用的函数，返回删除的指令数
+    void Linearize();           // 按原顺序重新排布保留的指令，修正跳转偏移，并重建控制流图
+    int FuncOf(int inst) const; // 指令所在的函数
+    void PrintCFG();
+    string ToString();
+
+private:
+    void AddEdge(int from, int to);
+    static bool IsCondJump(const Quadruple &q); // 条件跳转
+};
+
+#endif
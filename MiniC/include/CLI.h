@@ -8,10 +8,21 @@
 #define __CLI_H__
 
 #include <iostream>
+#include "Arena.h"
 #include "Scanner.h"
 #include "Parser.h"
 #include "SymTable.h"
 #include "IR.h"
+#include "CFG.h"
+#include "JumpThread.h"
+#include "Liveness.h"
+#include "BoundsCheck.h"
+#include "ConstEval.h"
+#include "FrameLayout.h"
+#include "Vectorize.h"
+#include "LoopUnroll.h"
+#include "MIR.h"
+#include "PassManager.h"
 #include "vm.h"
 
 class CLI
@@ -26,9 +37,18 @@ public:
     inline static const int FLAG_TRACE = 0x100000;   // 打印中间过程
     inline static const int FLAG_DEBUG = 0x1000000;  // 调试
 
+private:
+    int inlineSize{IR::INLINE_SIZE}; // 内联阈值
+    int inlineLeaf{IR::INLINE_LEAF}; // 叶子函数内联阈值
+    int boundsCheck{IR::BOUNDS_NEG}; // 数组越界检查级别
+    int evalSteps{ConstEval::EVAL_STEPS}; // 编译期求值的步数上限
+    int unrollFactor{LoopUnroll::UNROLL_FACTOR}; // 循环展开因子
+    PassManager passes;              // 优化级别和各遍的开关
+
 public:
     CLI() = default;
     void Parse(int argc, char **argv);              // 解析命令行参数
+    bool ParseOption(const string &opt);            // 解析长参数 --name=value
     void Compile(int flag, const string &filename); // 编译
     void Run(const string &filename);               // 运行
     void Debug(const string &filename);             // 调试
@@ -0,0 +1,99 @@
+/**
+ * ConstEval.h
+ * 编译期求值
+ *
+ * 在语法树上解释执行程序：
+ * 1. 不读取输入的 main 在步数限制内执行完毕时，函数体被替换为依次输出结果的 output(常数) 序列；
+ * 2. 否则，实参都是常数的函数调用在被调函数不访问全局变量、不输入输出时被替换为返回值。
+ * 除数为0、数组越界、读取未初始化的变量、超出步数或栈空间限制时放弃求值，保留运行时的行为。
+ * 算术运算按虚拟机的32位整数回绕，比较按 SUB 后与0比较的方式计算。
+ */
+
+#ifndef __CONSTEVAL_H__
+#define __CONSTEVAL_H__
+
+#include <map>
+#include <memory>
+#include <vector>
+#include "AST.h"
+#include "BuiltIn.h"
+#include "SymTable.h"
+
+using std::map;
+using std::vector;
+
+class EvalArray
+{
+public:
+    vector<int> data;
+    vector<bool> init; // 元素是否已赋值
+};
+
+using EvalArrayPointer = std::shared_ptr<EvalArray>;
+
+class EvalFrame
+{
+    /**
+     * 解释执行时的栈帧
+     */
+public:
+    map<SymNodePointer, int> vars;              // 已赋值的标量
+    map<SymNodePointer, EvalArrayPointer> arrs; // 数组和数组参数
+};
+
+class ConstEval
+{
+public:
+    long long steps{EVAL_STEPS}; // 单次求值的步数上限
+    int folded{0};               // 替换为常数的调用数
+    bool program{false};         // main 已整体在编译期求值
+
+    inline static const long long EVAL_STEPS{100000}; // 默认步数上限
+
+private:
+    inline static const int BUDGET_TIMES{20};  // 整个程序的总步数为单次上限的倍数
+    inline static const int MAX_STACK{512};    // 模拟的栈空间，超出时放弃，避免掩盖运行时的栈溢出
+    inline static const int FRAME_EXTRA{16};   // 每层调用额外估计的临时位置
+    inline static const int MAX_OUTPUT{256};   // main 求值最多的输出个数
+
+    // Exec 的结果
+    inline static const int EXEC_NEXT{0};
+    inline static const int EXEC_RETURN{1};
+    inline static const int EXEC_FAIL{2};
+
+    map<int, ASTNodePointer> funcs;                         // 用户定义的函数，按名称的编号
+    map<std::pair<int, vector<int>>, std::pair<bool, int>> cache;    // 已求值的调用
+    SymNodePointer outputSym{nullptr};
+
+    // 解释器状态
+    bool whole{false};    // 求值整个程序，允许访问全局变量和输出
+    long long left{0};    // 本次求值剩余的步数
+    long long budget{0};  // 剩余的总步数
+    int stack{0};         // 已使用的栈空间
+    int retval{0};        // 返回值
+    bool hasRet{false};   // return 语句带有返回值
+    EvalFrame globals;    // 全局变量
+    vector<int> outputs;  // main 的输出
+
+public:
+    ConstEval() = default;
+    int Run(AST &ast, SymTable &table); // 返回替换的调用数
+
+private:
+    bool Program(ASTNodePointer main);
+    void Fold(ASTNodePointer subTree);
+    bool FoldCall(ASTNodePointer subTree, int &v);
+    bool Call(ASTNodePointer subTree, EvalFrame &frame, int &v); // 计算实参并执行调用，v为返回值
+    bool Native(ASTNodePointer subTree, const BuiltIn &b, EvalFrame &frame, int &v); // 数组库函数
+    bool Invoke(ASTNodePointer func, const vector<int> &args, const vector<EvalArrayPointer> &arrs, int &v);
+    int Exec(ASTNodePointer subTree, EvalFrame &frame);
+    int ExecList(ASTNodePointer list, EvalFrame &frame);
+    bool Eval(ASTNodePointer subTree, EvalFrame &frame, int &v);
+    bool Assign(ASTNodePointer left, EvalFrame &frame, int v);
+    EvalArrayPointer Array(SymNodePointer sym, EvalFrame &frame);
+    bool Tick();
+    static int Wrap(long long v); // 按32位整数回绕
+    static ASTNodePointer MakeNum(const Token &tk, int v);
+};
+
+#endif
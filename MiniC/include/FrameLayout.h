@@ -0,0 +1,33 @@
+/**
+ * FrameLayout.h
+ * 栈帧布局
+ *
+ * 符号表建立时每个局部变量都独占一个位置。本遍重新计算函数内局部变量的偏移：
+ * 同一作用域的变量依次排列，并列的语句块互不重叠，从外层变量之后开始共用同一段空间。
+ * 完整越界检查时数组长度在函数入口一次性写入，因此数组仍然各自独占空间，只有标量重叠。
+ * 函数的 memloc 更新为重新布局后的大小，表达式临时位置从这里开始分配。
+ */
+
+#ifndef __FRAMELAYOUT_H__
+#define __FRAMELAYOUT_H__
+
+#include "SymTable.h"
+
+class FrameLayout
+{
+public:
+    int saved{0}; // 所有函数节省的栈帧位置数
+
+private:
+    bool header{false}; // 数组前保存长度
+
+public:
+    FrameLayout() = default;
+    int Run(SymTable &table); // 返回节省的位置数
+
+private:
+    int Arrays(SymNodePointer scope, int top);          // 依次放置作用域内全部数组，返回新的栈顶
+    int Place(SymNodePointer scope, int top, bool arr); // 放置作用域内的变量，并列的子作用域重叠，返回最大栈顶
+};
+
+#endif
@@ -11,16 +11,21 @@
 #include <sstream>
 #include "AST.h"
 #include "SymTable.h"
+#include "Loop.h"
+#include "BuiltIn.h"
 
 using std::map;
 using std::stringstream;
 using std::to_string;
 
+class MIR;
+
 // 三地址码(四元式)
 class Quadruple
 {
 public:
     int opt{-1};  // 指令类型 RO/RM
+    int ctrl{0};  // 控制转移类型，供控制流分析和重定位使用
     string iop;   // 操作符
     string addr1; // 地址
     string addr2;
@@ -31,6 +36,15 @@ public:
     inline static const int TYPE_RO{1}; // 指令类型
     inline static const int TYPE_RM{2};
 
+    // 控制转移类型
+    inline static const int CTRL_NONE{0}; // 顺序执行
+    inline static const int CTRL_JUMP{1}; // 相对PC的跳转 J**/LDA PC,d(PC)
+    inline static const int CTRL_CALL{2}; // 函数调用 LDC PC,entry
+    inline static const int CTRL_RET{3};  // 函数返回 LD PC,-2(BP)
+    inline static const int CTRL_HALT{4}; // 停机
+    inline static const int CTRL_ADDR{5}; // 装入代码地址(返回地址)的LDC，重定位时需要修正
+    inline static const int CTRL_TAIL{6}; // 尾调用 LDC PC,entry，复用当前栈帧，不会返回
+
 public:
     Quadruple() : iop("0"), addr1("0"), addr2("0"), addr3("0") {}
     Quadruple(const string &op) : iop(op), addr1("0"), addr2("0"), addr3("0") {}
@@ -40,9 +54,18 @@ public:
 
 class IR
 {
+    friend class MIR; // SSA中层代码直接生成指令
+
 public:
-    vector<Quadruple> qps; // 保存四元组
+    vector<Quadruple> qps;        // 保存四元组
+    map<string, int> inst_offset; // 函数指令入口位置
+    map<string, int> frameSize;   // 函数栈帧实际用到的大小，包括临时位置和调用序列
     bool FLAG_IR{true};
+    int inlineSize{INLINE_SIZE};  // 内联阈值：被调函数指令数不超过该值时在调用处展开
+    int inlineLeaf{INLINE_LEAF};  // 叶子函数(不调用其他函数)的内联阈值
+    int boundsCheck{BOUNDS_NEG};  // 数组越界检查级别
+    bool licm{true};              // 外提循环不变量
+    bool tailCall{true};          // 尾调用优化
 
 public:
     // 定义寄存器
@@ -50,36 +73,63 @@ public:
     inline static const string AC1{"1"}; // 累加器2
     inline static const string BP{"2"};  // 基址寄存器
     // inline static const string SP{"3"};
+    inline static const string AR1{"3"}; // 不含函数调用的循环内缓存数组基址
+    inline static const string AR2{"4"};
     inline static const string GP{"5"}; // 全局变量地址寄存器，一般情况下都为0,
     inline static const string FP{"6"}; // 栈帧指针，相当于SP
     inline static const string PC{"7"}; // 程序计数器
 
+    inline static const int RET_SIZE{3};     // 返回序列的指令数
+    inline static const int INLINE_SIZE{24}; // 默认内联阈值
+    inline static const int INLINE_LEAF{48};
+
+    // 数组越界检查级别
+    inline static const int BOUNDS_NONE{0}; // 不检查
+    inline static const int BOUNDS_NEG{1};  // 只检查负下标
+    inline static const int BOUNDS_FULL{2}; // 同时检查下标是否小于数组长度
+
 private:
-    int fp{0};                    // 栈帧指针
-    int gp{0};                    // 全局变量
-    map<string, int> inst_offset; // 函数指令入口位置
+    int fp{0};                          // 栈帧指针
+    int gp{0};                          // 全局变量
+    int frameTop{0};                    // 当前函数用到的栈帧最高位置
+    SymNodePointer curFunc{nullptr};    // 正在生成的函数
+    map<string, int> inst_end;          // 函数指令结束位置
+    LoopAnalysis loops;                 // 循环分析
+    map<ASTNodePointer, int> hoisted;   // 已外提的不变表达式在栈帧中的位置
+    map<SymNodePointer, string> arrReg; // 基址已缓存在寄存器中的数组
 
 public:
     void PrintIR();
     string ToString();
     void GenIR(AST &ast, SymTable &table);
+    void GenIR(MIR &mir, SymTable &table); // 由SSA中层代码生成
 
 private:
+    int GenStart(SymTable &table);                                 // 启动代码，返回调用main的指令位置
     void Gen(ASTNodePointer subTree, bool isAddr = false);         // 翻译Program
     void GenStmt(ASTNodePointer subTree, bool isAddr = false);     // 翻译statement
     void GenFunc(ASTNodePointer subTree);                          // 翻译函数声明
     void GenRet(ASTNodePointer subTree);                           // 翻译RETURN语句
     void GenIf(ASTNodePointer subTree);                            // 翻译IF语句
     void GenIter(ASTNodePointer subTree);                          // 翻译WHILE循环语句
+    void GenPreheader(const LoopInfo &loop, vector<ASTNodePointer> &exps, vector<SymNodePointer> &arrs); // 循环前置块
     void GenExp(ASTNodePointer subTree, bool isAddr = false);      //翻译表达式
+    bool GenConstOp(ASTNodePointer subTree);                       // 一个操作数是常数的算术运算
     void GenAS(ASTNodePointer subTree);                            // 翻译赋值表达式
     void GenFC(ASTNodePointer subTree);                            // 翻译函数调用
+    void GenArgs(ASTNodePointer args);                             // 从左到右计算实参，依次存放在fp开始的位置
+    void GenBuiltIn(ASTNodePointer subTree, const BuiltIn &b);     // 翻译为向量指令的内建函数
+    bool GenTailCall(ASTNodePointer subTree);                      // return f(...) 复用当前栈帧
     void GenAC(ASTNodePointer subTree, bool isAddr = false);       //翻译数组使用
+    bool GenInline(ASTNodePointer subTree);                        // 在调用处展开函数体
+    void GenArrHeader(SymNodePointer scope, const string &reg);    // 初始化作用域内数组的长度
     int EmitRO(string op, string r, string s, string t);           // 保存RO指令
     int EmitRM(string op, string r, string d, string s);           // 保存RM指令
     int EmitRO(string op, string r, string s, string t, string c); // 保存RO指令和注释
     int EmitRM(string op, string r, string d, string s, string c); // 保存RM指令和注释
     void EmitComment(string c, int ind = -1);                      // 添加注释
+    static int CtrlType(const string &op, const string &r, const string &s); // 识别控制转移指令
+    static int ParamCount(SymNodePointer func);                    // 函数的参数个数
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,55 @@
+/**
+ * JumpThread.h
+ * 跳转线程化
+ *
+ * 在控制流图上改写四元式中的跳转，重复以下变换直到不再变化：
+ * 1. 跳转到无条件跳转的，沿跳转链直接跳转到最终位置；
+ * 2. 跳转到下一条指令的跳转(空的 else 分支等)被删除；
+ * 3. 无条件跳转之后没有被引用的指令不可达，直接删除；
+ *    条件跳转越过一条无条件跳转时，反转条件并直接跳转到其目标，删除无条件跳转；
+ * 4. 寄存器的值由 LDC 确定时，对它的条件跳转的结果在编译期确定，
+ *    跳转到 LDC r,c; J** r 的跳转在 r 之后不再被读取时直接跳转到结果位置。
+ * 返回地址和函数入口指向的指令不会因反转而删除，最后由 CFG::Linearize 重新排布指令。
+ */
+
+#ifndef __JUMPTHREAD_H__
+#define __JUMPTHREAD_H__
+
+#include <vector>
+#include "IR.h"
+#include "CFG.h"
+
+using std::vector;
+
+class JumpThread
+{
+public:
+    int threaded{0}; // 改写目标的跳转数
+    int removed{0};  // 删除的指令数
+
+private:
+    inline static const int MAX_CHAIN{64}; // 跟随跳转链和向后扫描的最大指令数
+    CFG *cfg{nullptr};
+    IR *ir{nullptr};
+    vector<int> refs; // 以每条指令为目标的引用数，包括函数入口
+
+public:
+    JumpThread() = default;
+    int Run(CFG &cfg, IR &ir); // 返回改写和删除的指令数
+
+private:
+    bool Rewrite(int i);
+    void Retarget(int i, int t);
+    void Remove(int i);
+    int Next(int i) const;                       // i 及之后第一条保留的指令
+    int Prev(int i) const;                       // 顺序执行到 i 的前一条保留的指令，没有时为-1
+    int Final(int t) const;                      // 沿无条件跳转链到达的位置
+    bool Known(int i, const string &r, int &v) const; // 执行 i 之前寄存器r的值由前一条 LDC 确定
+    bool Dead(int t, const string &r, int &budget) const; // 从t开始寄存器r在被读取之前被改写
+    bool IsJump(int i) const;                    // 无条件跳转 LDA PC,d(PC)
+    bool IsCondJump(int i) const;                // 条件跳转 J** r,d(PC)
+    static bool Taken(const string &op, int v);  // 条件跳转在r=v时是否跳转
+    static string Inverse(const string &op);     // 相反的条件
+};
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ * Liveness.h
+ * 活跃变量分析和死存储消除
+ *
+ * 在控制流图上做逆向数据流分析，分析的位置包括寄存器 AC/AC1/BP/AR1/AR2、
+ * 栈帧中的标量局部变量和参数，以及地址没有被取出的临时位置。
+ * 写入后不再被读取的存储、结果不再被使用且没有副作用的指令被标记删除，
+ * 删除后重新分析直到不再变化，最后由 CFG::Linearize 重新排布指令。
+ *
+ * 标量一般只通过FP或同一基本块内 LDA r,d(FP) 得到的地址访问；
+ * 地址参与运算或离开基本块的位置视为逃逸，基址未知的读取被认为可能读取这些位置，
+ * 基址未知的写入不会被删除。
+ */
+
+#ifndef __LIVENESS_H__
+#define __LIVENESS_H__
+
+#include <map>
+#include <set>
+#include <vector>
+#include "IR.h"
+#include "CFG.h"
+#include "SymTable.h"
+
+using std::map;
+using std::set;
+using std::vector;
+
+class Liveness
+{
+public:
+    int removed{0}; // 删除的指令数
+
+private:
+    inline static const int NREG{5}; // 参与分析的寄存器 0-4，GP/FP/PC 总是活跃
+    CFG *cfg{nullptr};
+    IR *ir{nullptr};
+
+    // 一条指令读写的位置
+    class Effect
+    {
+    public:
+        vector<int> use;
+        vector<int> def;
+        bool side{false}; // 有副作用，不能删除
+    };
+
+public:
+    Liveness() = default;
+    int Run(CFG &cfg, IR &ir, SymTable &table); // 返回删除的指令数
+
+private:
+    int RunFunc(CFGFunc &f, SymNodePointer sym);
+    vector<Effect> Effects(CFGFunc &f, SymNodePointer sym, int &nloc);
+    bool Reads(CFGFunc &f, const vector<Effect> &effects, int block, int r); // 寄存器r在block之后被读取
+    static void Collect(SymNodePointer scope, set<int> &scalars, set<int> &arrays); // 函数内的标量和数组占用的位置
+};
+
+#endif
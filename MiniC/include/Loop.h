@@ -0,0 +1,60 @@
+/**
+ * Loop.h
+ * 循环分析
+ *
+ * MiniC 只有结构化的 while 循环：循环条件是唯一入口并支配整个循环体，
+ * 每个 while 语句就是一个自然循环，循环的嵌套关系直接由语法树给出。
+ * 分析每个循环内被赋值的变量、是否含有函数调用以及数组的使用次数，
+ * 找出循环不变的表达式，供生成中间代码时外提到循环前置块。
+ */
+
+#ifndef __LOOP_H__
+#define __LOOP_H__
+
+#include <map>
+#include <set>
+#include <vector>
+#include <string>
+#include "AST.h"
+#include "SymTable.h"
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+class LoopInfo
+{
+    /**
+     * 自然循环
+     */
+public:
+    ASTNodePointer node{nullptr};       // while 结点
+    int parent{-1};                     // 外层循环
+    int depth{1};                       // 嵌套深度
+    set<SymNodePointer> writes;         // 循环内被赋值的变量
+    bool hasCall{false};                // 循环内含有函数调用(内置函数除外)
+    map<SymNodePointer, int> arrays;    // 循环内数组的使用次数
+    vector<ASTNodePointer> invariants;  // 可以外提的循环不变表达式
+};
+
+class LoopAnalysis
+{
+public:
+    vector<LoopInfo> loops;
+    map<ASTNodePointer, int> loopOf; // while 结点对应的循环
+
+public:
+    LoopAnalysis() = default;
+    void Run(AST &ast);
+    const LoopInfo *Find(ASTNodePointer node) const;
+    bool IsInvariant(ASTNodePointer exp, const LoopInfo &loop) const; // 表达式在循环内是否不变
+    static string Key(ASTNodePointer exp);                            // 表达式的结构，结构相同的不变表达式只计算一次
+    static bool IsBuiltin(SymNodePointer sym);                        // 内置函数，不修改局部变量
+
+private:
+    void Visit(ASTNodePointer subTree, int loop);
+    void Collect(ASTNodePointer subTree, LoopInfo &loop);
+};
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * LoopUnroll.h
+ * 循环展开
+ *
+ * MiniC 没有 for 语句，计数循环写作 while (x < e) { ...; x = x + c; }。
+ * 循环体顶层恰好有一条 x = x + c (c > 0) 修改局部变量x，e 是常数或在循环内不变的变量时：
+ * 1. 循环前的语句为 x = 常数、e 是常数且迭代次数很少时完全展开为依次执行的循环体副本；
+ * 2. 否则按展开因子k展开：主循环在 x < e - (k-1)*c 时连续执行k份循环体，
+ *    原循环作为余数循环放在主循环之后，处理剩下的迭代。
+ * 虚拟机按 SUB 的结果判断大小，差值会回绕。进入主循环时原条件成立，则主循环的条件成立
+ * 意味着k份循环体各自的原条件都成立；不能在编译期确定时在主循环前检查一次原条件。
+ * 只展开最内层、不含函数调用的循环。
+ */
+
+#ifndef __LOOPUNROLL_H__
+#define __LOOPUNROLL_H__
+
+#include <vector>
+#include "AST.h"
+#include "SymTable.h"
+
+using std::vector;
+
+class LoopUnroll
+{
+public:
+    int factor{UNROLL_FACTOR}; // 展开因子
+    int unrolled{0};           // 按展开因子展开的循环数
+    int flattened{0};          // 完全展开的循环数
+
+    inline static const int UNROLL_FACTOR{4}; // 默认展开因子
+    inline static const int MAX_FACTOR{16};
+
+private:
+    inline static const int MAX_BODY{64};   // 按因子展开的循环体最多的结点数
+    inline static const int FULL_TRIPS{16}; // 完全展开的最多迭代次数
+    inline static const int FULL_SIZE{256}; // 完全展开后最多的结点数
+
+public:
+    LoopUnroll() = default;
+    void Run(AST &ast);
+
+private:
+    void Visit(ASTNodePointer list);
+    bool Unroll(ASTNodePointer loop, ASTNodePointer prev);   // prev 为循环前的语句
+    ASTNodePointer Copies(ASTNodePointer body, long long n); // n 份循环体副本组成的复合语句
+    int CountAssign(ASTNodePointer subTree, SymNodePointer sym);
+    bool HasCall(ASTNodePointer subTree);
+    bool HasLoop(ASTNodePointer subTree);
+    int CountNodes(ASTNodePointer subTree);
+    ASTNodePointer MakeNum(const Token &tk, long long v);
+    ASTNodePointer MakeOp(const Token &tk, StmtType st, TokenType op, ASTNodePointer l, ASTNodePointer r);
+    static bool Compare(TokenType op, long long x, long long e); // 按虚拟机的方式比较
+};
+
+#endif
@@ -0,0 +1,179 @@
+/**
+ * MIR.h
+ * SSA形式的中层中间代码
+ *
+ * 从带类型的语法树生成：局部变量和参数成为虚拟寄存器，数组和全局变量留在内存中，
+ * 内存状态也作为一个虚拟寄存器参与SSA构造，读写内存的指令以它为操作数。
+ * 采用按需构造SSA的方法(Braun et al.)，在 if/while 的汇合处插入phi结点。
+ * 在支配树上做全局值编号，消除公共子表达式和重复的数组读取，
+ * 对循环中的归纳变量做强度削弱，最后消去phi结点，翻译为虚拟机指令。
+ */
+
+#ifndef __MIR_H__
+#define __MIR_H__
+
+#include <climits>
+#include <map>
+#include <vector>
+#include <string>
+#include "AST.h"
+#include "SymTable.h"
+#include "IR.h"
+
+using std::map;
+using std::string;
+using std::vector;
+
+class MInst
+{
+    /**
+     * 中层指令
+     * dst 定义的值，mdst 定义的内存状态，mem 使用的内存状态
+     */
+public:
+    int op{0};                   // 操作码
+    int dst{-1};                 // 结果
+    int mdst{-1};                // 新的内存状态
+    int mem{-1};                 // 读取的内存状态
+    vector<int> args;            // 操作数
+    vector<int> blocks;          // 跳转目标
+    long long imm{0};            // 常数或关系运算符
+    SymNodePointer sym{nullptr}; // 数组、全局变量或被调函数
+    int attr{0};                 // 数组访问已证明安全的检查
+    bool dead{false};            // 已删除
+
+public:
+    inline static const int CONST{1}; // dst = imm
+    inline static const int ADD{2};   // dst = a + b
+    inline static const int SUB{3};
+    inline static const int MUL{4};
+    inline static const int DIV{5};
+    inline static const int CMP{6};     // dst = a imm b，结果为0或1
+    inline static const int LOAD{7};    // dst = sym[a]
+    inline static const int STORE{8};   // sym[a] = b
+    inline static const int GLOAD{9};   // dst = sym (全局变量)
+    inline static const int GSTORE{10}; // sym = a
+    inline static const int ADDR{11};   // dst = 数组sym的基址
+    inline static const int SIZE{12};   // dst = 数组sym的长度
+    inline static const int CALL{13};   // dst = sym(args...)
+    inline static const int IN{14};     // dst = input()
+    inline static const int OUT{15};    // output(a)
+    inline static const int PHI{16};    // dst = phi(args...)，与前驱一一对应
+    inline static const int COPY{17};   // 并行复制 args[2i] = args[2i+1]，用于消去phi
+    inline static const int BR{18};     // if (a) goto blocks[0] else goto blocks[1]
+    inline static const int JMP{19};    // goto blocks[0]
+    inline static const int RET{20};    // return [a]
+    inline static const int SHL{21};    // dst = a << imm
+    inline static const int SHR{22};    // dst = a >> imm，被除数非负的除法
+    inline static const int LOADP{23};  // dst = mem[a + imm]，a为数组元素的地址
+    inline static const int STOREP{24}; // mem[a + imm] = b
+    inline static const int VEC{25};    // [dst =] sym(args...)，翻译为向量指令的内建函数
+
+public:
+    MInst() = default;
+    MInst(int o) : op(o) {}
+    bool IsTerminator() const { return op == BR || op == JMP || op == RET; }
+    bool IsPure() const; // 没有副作用，结果不用时可以删除
+};
+
+class MBlock
+{
+    /**
+     * 基本块，phi结点单独保存在块首
+     */
+public:
+    int id{0};
+    vector<MInst> phis;
+    vector<MInst> insts;
+    vector<int> preds;
+    vector<int> succs;
+    bool sealed{false};                    // 前驱已经全部确定
+    bool reachable{false};                 // 从入口可达
+    int idom{-1};                          // 直接支配者
+    vector<int> children;                  // 支配树上的子结点
+    map<SymNodePointer, int> incomplete;   // 未封闭时为变量创建的phi
+};
+
+class MFunc
+{
+    /**
+     * 函数
+     */
+public:
+    string name;
+    SymNodePointer sym{nullptr};
+    vector<MBlock> blocks;
+    vector<int> order;                // 生成指令时基本块的排布顺序
+    int nvalue{0};                    // 虚拟寄存器数
+    vector<bool> isMem;               // 虚拟寄存器是否表示内存状态
+    map<int, int> params;             // 参数的初值及其在栈帧中的位置
+    map<int, long long> consts;       // 常数值
+    vector<int> alias;                // 被替换的值
+    int zero{-1};                     // 未初始化变量的值
+    int mem0{-1};                     // 函数入口的内存状态
+
+public:
+    int NewValue(bool mem = false);
+    int Find(int v);               // 替换后的值
+    void Replace(int from, int to); // 用to代替from的所有使用
+};
+
+class MIR
+{
+public:
+    vector<MFunc> funcs;
+    int boundsCheck{IR::BOUNDS_NEG}; // 数组越界检查级别
+    int removed{0};                  // 值编号删除的指令数
+
+private:
+    inline static const int INDENT{4};
+    inline static const int SLOT_NEED{INT_MIN + 1}; // 需要栈帧位置，尚未分配
+    MFunc *func{nullptr};
+    int cur{-1};                                  // 当前基本块
+    map<SymNodePointer, map<int, int>> defs;      // 变量在各基本块末尾的定义
+
+public:
+    MIR() = default;
+    void Build(AST &ast);  // 由语法树生成SSA
+    void GVN();            // 全局值编号
+    void Lower(IR &ir);    // 消去phi并生成虚拟机指令
+    void PrintMIR();
+    string ToString();
+
+private:
+    // SSA构造
+    void BuildFunc(ASTNodePointer subTree);
+    void Stmt(ASTNodePointer subTree);
+    int Expr(ASTNodePointer subTree);
+    int Call(ASTNodePointer subTree);
+    int NewBlock(bool sealed);
+    void AddEdge(int from, int to);
+    MInst &Emit(MInst inst);
+    int Const(long long v);
+    bool Terminated();
+    void WriteVar(SymNodePointer var, int block, int v);
+    int ReadVar(SymNodePointer var, int block);
+    int ReadVarRecursive(SymNodePointer var, int block);
+    int NewPhi(int block, SymNodePointer var);
+    void AddPhiOperands(SymNodePointer var, int block, int phi);
+    void SealBlock(int block);
+    void RemoveTrivialPhis(MFunc &f);
+    void RemoveUnreachable(MFunc &f);
+
+    // 优化
+    void Dominators(MFunc &f);
+    void GVN(MFunc &f);
+    void DCE(MFunc &f);
+    bool Fold(MFunc &f, MInst &inst);
+    void Strength(MFunc &f); // 归纳变量的强度削弱
+
+    // 生成指令
+    void SplitCriticalEdges(MFunc &f);
+    void DestructSSA(MFunc &f);
+    void LowerFunc(IR &ir, MFunc &f, map<int, string> &calls);
+    int PackSlots(MFunc &f, vector<int> &slot, const map<int, int> &coalesce, int base); // 按生存期分配栈帧位置，返回栈帧大小
+
+    static void ResolveArgs(MFunc &f, MInst &inst);
+};
+
+#endif
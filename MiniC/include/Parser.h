@@ -2,6 +2,9 @@
  * Parser.h
  * 语法分析器
  *
+ * 记号按需从词法分析器取得，保存在大小固定的环形窗口中，
+ * 序号为 i 的记号位于 window[i % WINDOW]。PeekToken 最多向后查看 LOOKAHEAD 个记号，
+ * PrevToken 最多向前查看 HISTORY 个记号，内存占用与源文件长度无关。
  */
 
 #ifndef __PARSER_H__
@@ -15,20 +18,30 @@ using std::vector;
 
 class Parser
 {
+private:
+    inline static const unsigned int WINDOW{8}; // 记号窗口的大小，2的幂
+    inline static const int LOOKAHEAD{2};       // 最多向后查看的记号数
+    inline static const int HISTORY{2};         // 最多向前查看的记号数
+    static_assert((WINDOW & (WINDOW - 1)) == 0 && LOOKAHEAD + HISTORY < static_cast<int>(WINDOW));
+
 private:
     AST tree;                             // 语法树
     string filename;                      // 文件名
-    unsigned int listIdx{0};              // 记录当前Token的位置
+    Scanner *scanner{nullptr};            // 记号来源
+    unsigned int listIdx{0};              // 下一个要取的记号的序号
+    unsigned int fetched{0};              // 已从词法分析器取得的记号数
+    bool atEnd{false};                    // 已取得结束记号
     Token curToken{TokenType::NONE, "#"}; // 当前token
-    vector<Token> tokenList;              //词法分析器的token列表
+    vector<Token> window;                 // 最近取得的记号
 
 private:
     bool BuildAST();
-    Token &GetToken();
-    Token &PrevToken(int prev = 1); // 向前查看Token
-    Token &PeekToken(int peek = 1); // 向后查看Token
+    const Token &Fetch(unsigned int idx); // 序号为 idx 的记号，超过结束记号时为结束记号
+    const Token &GetToken();
+    const Token &PrevToken(int prev = 1); // 向前查看Token
+    const Token &PeekToken(int peek = 1); // 向后查看Token
     void Match(TokenType expect);
-    void EmitError(const string &error, Token &tk);
+    void EmitError(const string &error, const Token &tk);
 
 public:
     bool Parse(const char *filename); // 从指定文件解析语法
@@ -0,0 +1,87 @@
+/**
+ * PassManager.h
+ * 优化遍管理
+ *
+ * 登记语法树和中间代码上的优化遍，按优化级别 -O0/-O1/-O2 决定默认启用的遍，
+ * 命令行 --<遍名>=0|1 可以单独关闭或打开某一遍。
+ * 开启 --time-passes 时记录每个阶段的耗时、处理前后的规模(记号/结点/指令数)和数据结构占用的内存。
+ */
+
+#ifndef __PASSMANAGER_H__
+#define __PASSMANAGER_H__
+
+#include <functional>
+#include <string>
+#include <vector>
+#include "Scanner.h"
+#include "AST.h"
+#include "IR.h"
+#include "MIR.h"
+
+using std::function;
+using std::string;
+using std::vector;
+
+class PassSize
+{
+    /**
+     * 中间表示的规模
+     */
+public:
+    long long units{0}; // 记号数、语法树结点数或指令数
+    long long bytes{0}; // 占用的内存
+};
+
+class PassInfo
+{
+public:
+    string name;    // 遍名，同时是命令行参数名
+    int level{0};   // 默认启用该遍的最低优化级别
+    string desc;    // 说明
+    int state{-1};  // -1 由优化级别决定，0 关闭，1 打开
+};
+
+class PassStat
+{
+public:
+    string name;
+    double ms{0};    // 耗时(毫秒)
+    PassSize before; // 处理前的规模
+    PassSize after;  // 处理后的规模
+};
+
+class PassManager
+{
+public:
+    inline static const int O0{0}; // 不做可选的优化
+    inline static const int O1{1}; // 默认级别
+    inline static const int O2{2}; // 经由SSA中层代码生成
+
+    int level{O1};          // 优化级别
+    bool timePasses{false}; // 打印各阶段耗时
+
+private:
+    vector<PassInfo> passes; // 登记的优化遍
+    vector<PassStat> stats;  // 已执行阶段的统计
+
+public:
+    PassManager();
+    bool SetLevel(int level);                  // 设置优化级别
+    bool Set(const string &name, bool on);     // 单独打开或关闭一遍，遍名不存在时返回false
+    bool Enabled(const string &name);          // 是否执行该遍
+    void Time(const string &name, const function<void()> &body, const function<PassSize()> &measure); // 执行并统计一个阶段
+    bool Run(const string &name, const function<void()> &body, const function<PassSize()> &measure);  // 遍启用时执行，返回是否执行
+    void PrintTimes();
+    string Usage();
+
+    static PassSize Measure(Scanner &scanner);
+    static PassSize Measure(AST &ast);
+    static PassSize Measure(MIR &mir);
+    static PassSize Measure(IR &ir);
+
+private:
+    PassInfo *Find(const string &name);
+    static long long CountNodes(ASTNodePointer subTree);
+};
+
+#endif
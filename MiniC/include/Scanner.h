@@ -2,6 +2,12 @@
  * Scanner.h
  * 词法分析器
  *
+ * 整个源文件一次读入内存，用指针逐个扫描字符，回退不受缓存区边界的限制。
+ * 扫描时不逐字符维护行列号，记号的行号和列号由其首字符的偏移在行首索引中查找得到。
+ * 空白、注释内容、标识符和常数按块跳过：编译时打开 AVX2 每次比较32字节，
+ * 否则使用 SSE2 每次比较16字节，都不支持时逐个字符比较。
+ * 语法分析器通过 NextToken 逐个取记号，不需要保存整个记号列表；
+ * 只有打印记号时才用 Scan 扫描出完整的列表。
  */
 #ifndef __SCANNER_H__
 #define __SCANNER_H__
@@ -30,8 +36,6 @@ enum class StateType
     DONE,      // 完成
     ERROR,     // 错误
     INCOMMENT, // 注释
-    INNUM,     // 常数
-    INID,      // 标识符
     MORE       // 查看下一个字符
 };
 
@@ -42,29 +46,37 @@ public:
     bool FLAG_SCANNER{true};  // 状态: true扫描成功
 
 private:
-    int row{1};            // 当前字符的行号
-    int col{0};            // 当前字符的列号
-    int lineLen{0};        // 缓存区的长度
-    int linePos{0};        // 缓存区的下标
-    int bufferSize{1024};  // 缓存区大小
-    char *buffer{nullptr}; // 缓存
+    string source;             // 一次读入的整个源文件
+    const char *cur{nullptr};  // 下一个字符
+    const char *end{nullptr};  // 源文件末尾，*end 为 '\0'
+    vector<size_t> lineStart;  // 每一行第一个字符的偏移
+    size_t lastLine{0};        // 上一个记号所在的行
 
-    ifstream ifs;            // 文件流
     vector<Token> tokenList; // 保存扫描到的Token序列
+    size_t next{0};          // 下一个由 NextToken 返回的记号的序号
 
 public:
-    Scanner();
-    ~Scanner();
+    Scanner() = default;
+    bool Open(const string &filename); // 读入源文件，之后由 NextToken 逐个取记号
     bool Scan(const string &filename); // 从文件中扫描记号
+    Token NextToken();                 // 取下一个记号：开始记号、源程序中的记号、结束记号
+    size_t TokenCount() const;         // 已扫描的记号数
     vector<Token> &GetTokenList();     // 获取Token列表
     void PrintTokenList();             // 构建
     string ToString();                 // 构建
 
 private:
-    bool FillBuffer();  // 填充缓存区
-    char GetNextChar(); //获取字符
-    void PutBackChar(); // 回退字符
-    Token GetToken();   // 获取下一个Token
+    bool Load(const string &filename);                 // 读入整个文件并建立行首索引
+    void Locate(size_t offset, int &row, int &col);    // 由偏移计算行号和列号
+    char GetNextChar();                                // 获取字符
+    void PutBackChar();                                // 回退字符
+    Token GetToken();                                  // 获取下一个Token
+
+    // 按块扫描，返回第一个不满足条件的位置，不超过 end
+    static const char *SkipSpace(const char *p, const char *end);      // 跳过空白
+    static const char *SpanAlpha(const char *p, const char *end);      // 跳过字母
+    static const char *SpanDigit(const char *p, const char *end);      // 跳过数字
+    static const char *FindCommentEnd(const char *p, const char *end); // 注释结尾 "*/" 的位置
 };
 
 #endif
\ No newline at end of file
@@ -2,7 +2,10 @@
  * SymTable.h
  * 符号表和类型检查
  *
- * 采用链表实现
+ * 采用链表实现，符号结点从当前的 Arena 中分配，随内存池一起释放
+ * 构建时另按名称编号索引当前可见的符号，同名符号通过 shadow 串成遮蔽链，
+ * 进入作用域时记录位置，退出时撤销其中的绑定，查找为 O(1)。
+ * 符号的种类、存储类别和类型用枚举保存，标记字符串只在打印时生成。
  *
  */
 #ifndef __SYMTABLE_H__
@@ -12,11 +15,13 @@
 #include <cstring>
 #include <string>
 #include <string_view>
+#include <utility>
 
 #include "Token.h"
 #include "AST.h"
 #include "MCLog.h"
 
+using std::pair;
 using std::string;
 using std::string_view;
 using std::vector;
@@ -24,21 +29,59 @@ using std::vector;
 class SymNode;
 using SymNodePointer = SymNode *;
 
+enum class SymKind : int8_t
+{
+    /* 符号种类 */
+    SCOPE, // 全局作用域
+    BLOCK, // 语句块
+    VAR,   // 变量
+    ARR,   // 数组
+    FUNC,  // 函数
+};
+
+enum class Storage : int8_t
+{
+    /* 存储类别 */
+    NONE,   // 作用域、语句块
+    GLOBAL, // 全局
+    PARAM,  // 参数
+    LOCAL,  // 局部
+};
+
+enum class SymType : char
+{
+    /* 返回值和参数类型，取值即标记中的字符 */
+    INT = 'I',
+    ARR = 'A',
+    VOID = 'V',
+};
+
 class SymNode
 {
     // 符号结点
 public:
+    inline static const int8_t USER{-1};   // 源程序声明的符号
+    inline static const int8_t INPUT{-2};  // 内建函数 input
+    inline static const int8_t OUTPUT{-3}; // 内建函数 output
+
     int memloc{0};                   // 对于全局或函数作用域：空间的分配大小；对于变量、数组、参数：内存中的偏移位置
-    string tag;                      // 符号标记，对于函数：F:G:name:RET_TPYE:PARAM_TYPES，对于变量：V:作用域:大小
+    SymKind kind{SymKind::SCOPE};    // 符号种类
+    Storage storage{Storage::NONE};  // 存储类别
+    SymType rtype{SymType::VOID};    // 函数的返回值类型
+    int8_t builtin{USER};            // 内建函数：INPUT、OUTPUT 或 BuiltIn::TABLE 的下标
+    int length{1};                   // 数组声明的长度，数组形参为-1
+    vector<SymType> ptype;           // 函数的参数类型，参数为void时只有一个 VOID
     TokenPointer token_ptr{nullptr}; // 单词
     SymNodePointer prev{nullptr};    // 前一个符号或作用域
     SymNodePointer next{nullptr};    // 下一个符号或作用域
     SymNodePointer scope{nullptr};   // 当前作用域内的变量声明
+    SymNodePointer shadow{nullptr};  // 被当前符号遮蔽的同名符号，只在构建时使用
 
 public:
-    SymNode() : scope(this) {}
-    SymNode(const string &t) : tag(t), scope(this) {}
+    SymNode(SymKind k = SymKind::SCOPE, Storage s = Storage::NONE) : kind(k), storage(s), scope(this) {}
     ~SymNode() {}
+    static void *operator new(size_t size); // 从当前内存池分配
+    static void operator delete(void *ptr); // 由内存池整体释放，不能直接 delete
     bool IsVar();                     // 是否变量
     bool IsArr();                     // 是否数组
     bool IsFunc();                    // 是否函数
@@ -49,8 +92,10 @@ public:
     bool IsLocal();                   // 是否局部
     void Insert(SymNodePointer node); // 向当前作用域插入符号，头插入法
     int Allocate(size_t size);        // 分配内存
-    string_view GetRType();           //获取返回值类型
-    string_view GetPType();           // 获取参数类型
+    SymType GetRType();               // 获取返回值类型
+    const vector<SymType> &GetPType(); // 获取参数类型
+    int GetArrSize();                 // 获取数组声明的长度，数组形参返回-1
+    string Tag();                     // 打印用的符号标记，函数：F:G:name:RET_TYPE:PARAM_TYPES，变量：V:作用域:name:大小
     SymNodePointer GetFP();           // 获取函数的声明
 };
 
@@ -62,15 +107,18 @@ class SymTable
 public:
     bool FLAG_SYMTAB{true};
     bool FLAG_TYPECHECK{true};
+    bool arrayHeader{false}; // 数组前预留一个位置保存长度，供越界检查使用
     SymNodePointer symtab{nullptr};
 
 private:
     inline static const int INDENT{4};
     ASTNodePointer root{nullptr};
+    vector<SymNodePointer> visible; // 按名称编号索引当前可见的符号
+    vector<SymNodePointer> bound;   // 按绑定顺序记录的符号
+    vector<size_t> scopes;          // 每层作用域开始时 bound 的长度
 
 public:
     SymTable() = default;
-    ~SymTable();
     bool Build(AST &ast);  // 构建符号表
     bool TypeCheck();      //类型检查
     void PrintTable();     // 打印符号表
@@ -80,10 +128,15 @@ public:
 private:
     void InitBuiltIn(); // 向符号表加入内建函数
     void TypeCheck(ASTNodePointer subTree);
-    void Destroy(SymNodePointer node);
+    void Check(ASTNodePointer subTree); // 检查单个结点，子结点已经检查过
     void PrintTable(SymNodePointer subTable, string &buffer, int indent = 0);
     void PrintReference(ASTNodePointer subTree, string &buffer, int indent = 0);
-    SymNodePointer LookUp(const string &tname, SymNodePointer node); // 查找符号
+    void PrintReference(ASTNodePointer subTree, string &buffer, int indent, vector<pair<ASTNodePointer, int>> &stack); // 打印结点本身，子结点和兄弟结点入栈
+    SymNodePointer LookUp(int id);       // 按名称的编号查找当前可见的符号
+    SymNodePointer LookUpGlobal(int id); // 查找全局作用域中的符号，忽略局部的同名符号
+    void Bind(SymNodePointer symbol);    // 符号在当前作用域内可见
+    void PushScope();                    // 进入作用域
+    void PopScope();                     // 退出作用域，撤销其中的绑定
     void Build(ASTNodePointer ast, SymNodePointer node);
     void AddVar(ASTNodePointer subTree, SymNodePointer node, int pn = 0); // 向作用域添加变量，pn是否参数结点，影响内存的偏移
     void AddArr(ASTNodePointer subTree, SymNodePointer node, int pn = 0); // 添加数组
@@ -2,11 +2,19 @@
  * Token.h
  * Token的数据结构
  *
+ * 记号名称保存在全局字符串表中，Token 只持有其编号，名称由编号查表得到，
+ * 复制记号不分配内存，比较名称只需比较编号。字符串表只增不减，其中的字符串地址不变。
+ * 记号类型只占一个字节，整个记号为16字节。
+ * 关键字用完美散列查找，运算符和分隔符按首字符查表。
  */
 #ifndef __TOKEN_H__
 #define __TOKEN_H__
 
+#include <array>
+#include <cstdint>
+#include <deque>
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <string>
 #include <string_view>
@@ -21,7 +29,7 @@ using std::vector;
 
 using TokenPointer = Token *;
 
-enum class TokenType
+enum class TokenType : int8_t
 {
     INVALID = -1,
     NONE = 0,
@@ -60,33 +68,50 @@ class Token
 {
 public:
     TokenType type; // 记号类型
-    string val;     // 记号名称
+    int id{-1};     // 记号名称在全局字符串表中的编号，名称相同则编号相同
     int row{0};     // 出现的行号
     int col{0};     // 列号
 
 private:
-    static const Token KEYWORD_LIST[]; // 保留关键字
-    static const Token SYMBOL_LIST[];  // 保留运算符
     static const Token RELOP_LIST[];   // 关系运算符
     static const Token MATHOP_LIST[];  // 四则运算符
-    static const Token SEPARATE[];     // () [] {} , ; 分割符
-
-    static const Token PEEK_TOKEN[]; // 双字符的关键字
     static map<TokenType, string_view> translation;
 
+    // 关键字的完美散列：KeywordHash 在 KEYWORD_HASH 中的位置各不相同
+    inline static constexpr int KEYWORD_SLOTS{8};
+    inline static constexpr string_view KEYWORD_HASH[KEYWORD_SLOTS] = {"int", "", "return", "", "else", "if", "void", "while"};
+    inline static constexpr TokenType KEYWORD_TYPE[KEYWORD_SLOTS] = {TokenType::INT, TokenType::ID, TokenType::RETURN,
+                                                                     TokenType::ID, TokenType::ELSE, TokenType::IF,
+                                                                     TokenType::VOID, TokenType::WHILE};
+    // 运算符和分隔符按首字符直接索引，SYMBOL_EQ 是首字符后接 '=' 的双字符运算符
+    inline static constexpr int SYMBOL_SLOTS{128};
+    static const std::array<TokenType, SYMBOL_SLOTS> SYMBOL;
+    static const std::array<TokenType, SYMBOL_SLOTS> SYMBOL_EQ;
+
 public:
     static bool IsNeedMore(char c);                      // 需要根据下一个字符进行判断，如 =和==, /和/*, *和*/
     static TokenType GetSymbolType(string_view sv);      // 分隔符类型 ,;[]等
     static TokenType GetKeywordType(string_view sv);     // 关键字和标识符
     static string_view GetTokenTranslation(TokenType t); // 类型转string
+    static int Intern(string_view sv);                   // 加入全局字符串表，返回编号
+    static string_view Name(int id);                     // 编号对应的字符串，-1 为空串
 
 public:
-    Token() : type(TokenType::NONE), val("") {}
-    Token(TokenType t, string v) : type(t), val(v) {}
+    Token() : type(TokenType::NONE) {}
+    Token(TokenType t, string_view v) : type(t), id(Intern(v)) {}
     bool IsTypeOf(const TokenType &type) const;
+    string_view Text() const; // 记号名称
+    long long Value() const; // 常数记号的值
     bool IsTypeOfMathOp(); // 四则运算
     bool IsTypeOfRelOp();  // 关系运算
     string GetTypeName();  // 记号名称
+
+private:
+    static constexpr int KeywordHash(string_view sv);
+    static constexpr bool CheckKeywordHash();
+    static constexpr std::array<TokenType, SYMBOL_SLOTS> MakeSymbolTable(bool eq);
+    static std::deque<string> &Names();                 // 全局字符串表
+    static std::unordered_map<string_view, int> &Ids(); // 字符串到编号
 };
 
 #endif
\ No newline at end of file
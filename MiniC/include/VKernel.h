@@ -0,0 +1,38 @@
+/**
+ * VKernel.h
+ * 向量指令在虚拟机内存上的实现
+ *
+ * 编译时打开 AVX2(-mavx2)则每次处理8个元素，否则使用 SSE2 每次处理4个元素，
+ * 都不支持时逐个元素计算。整数运算与虚拟机的标量指令一样按32位回绕。
+ * 目标区间与源区间部分重叠且位于其后时，逐个元素按从低到高的顺序计算，
+ * 结果与等价的标量循环相同。
+ */
+
+#ifndef __VKERNEL_H__
+#define __VKERNEL_H__
+
+class VKernel
+{
+public:
+    inline static const int ADD{0};
+    inline static const int SUB{1};
+    inline static const int MUL{2};
+
+public:
+    static void Binary(int op, int *dst, const int *a, const int *b, int n); // dst[i] = a[i] op b[i]
+    static void Fill(int *dst, int v, int n);                               // dst[i] = v
+    static void Copy(int *dst, const int *src, int n);                      // dst[i] = src[i]
+    static int Sum(const int *a, int n);                                    // a[0] + ... + a[n-1]
+    static void Sort(int *a, int n);                                        // 升序排序
+    static int Extreme(const int *a, int n, bool max);                      // 最小值或最大值，n > 0
+    static int Find(const int *a, int v, int n);                            // 第一个等于 v 的下标，不存在时为-1
+
+private:
+    template <int OP>
+    static int Scalar(int x, int y);
+    template <int OP>
+    static void Kernel(int *dst, const int *a, const int *b, int n, bool ordered); // ordered 时逐个元素计算
+    static bool Behind(const int *dst, const int *src, int n); // dst 落在 (src, src+n) 内，需要按顺序计算
+};
+
+#endif
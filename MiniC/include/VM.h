@@ -41,6 +41,20 @@ enum class OPCODE
     SUB,  // -
     MUL,  // 
     DIV,
+    AND,  // 按位与
+    OR,   // 按位或
+    XOR,  // 按位异或
+    // 向量指令，对 dMem 中连续的 n = reg[AC] 个元素操作，r,s,t 为保存起始地址的寄存器
+    VADD,  // mem[reg[r]+i] = mem[reg[s]+i] op mem[reg[t]+i]
+    VSUB,  // -
+    VMUL,  //
+    VFILL, // mem[reg[r]+i] = reg[s]
+    VCOPY, // mem[reg[r]+i] = mem[reg[s]+i]
+    VSUM,  // reg[r] = mem[reg[s]] + ... + mem[reg[s]+n-1]
+    VSORT, // mem[reg[r]..reg[r]+n) 升序排序
+    VMIN,  // reg[r] = min(mem[reg[s]+i])，n <= 0 时为0
+    VMAX,  // reg[r] = max(mem[reg[s]+i])，n <= 0 时为0
+    VFIND, // reg[r] = 第一个 mem[reg[s]+i] == reg[t] 的 i，不存在时为-1
     RRLim,
 
     /**
@@ -57,6 +71,8 @@ enum class OPCODE
      */
     LDA,
     LDC,  
+    SHL,  // reg[r] = reg[s] << d，移位数是立即数
+    SHR,  // reg[r] = reg[s] >> d，算术右移
     JLT,
     JLE,
     JEQ,
@@ -76,6 +92,7 @@ enum class VMSTATUS
     VMError,                  // 出错
     ZeroDivisionError,        // ÷0
     NegativeArrayOffsetError, // 负下标
+    ArrayOffsetRangeError,    // 下标越界
 
 };
 
@@ -124,6 +141,9 @@ public:
     void Debug();                          // 调试
     void PrintRegister();                  // 打印寄存器和内存
     void PrintError(VMSTATUS e);           // 打印错误
+
+private:
+    bool InRange(int addr, int n);         // [addr, addr+n) 在内存范围内
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,52 @@
+/**
+ * Vectorize.h
+ * 按元素运算的循环向量化
+ *
+ * 计数循环 while (i < n) { ...; i = i + 1; } 在 i = i + 1 之前只有以下语句时：
+ *   c[i] = a[i] op b[i] (op 为 + - *)、c[i] = a[i]、c[i] = v (v 为常数或循环内不变的变量)、
+ *   s = s + a[i] (s 不在循环的其他地方出现)，
+ * 整个循环改写为 if (i < n) { 对 [i, n) 执行的向量内建函数...; i = n; }。
+ * 所有数组都以同一个 i 为下标，不同的数组参数至多整体重合而不会错开，
+ * 每条语句整体执行与逐次迭代交替执行的结果相同；区间错开重叠时虚拟机按顺序逐个计算。
+ * i 是局部变量，n 是常数或循环内不变的变量，进入时 i < n 则循环恰好在 i == n 时结束。
+ * 数组访问还需要越界检查时保留原循环。
+ */
+
+#ifndef __VECTORIZE_H__
+#define __VECTORIZE_H__
+
+#include <map>
+#include <string>
+#include "AST.h"
+#include "SymTable.h"
+#include "IR.h"
+
+using std::map;
+using std::string;
+
+class Vectorize
+{
+public:
+    int boundsCheck{IR::BOUNDS_NEG}; // 数组越界检查级别
+    int vectorized{0};               // 向量化的循环数
+
+private:
+    map<string, SymNodePointer> builtins; // 向量内建函数的符号
+
+public:
+    Vectorize() = default;
+    void Run(AST &ast, SymTable &table);
+
+private:
+    void Visit(ASTNodePointer list);
+    bool Rewrite(ASTNodePointer loop);
+    bool Match(ASTNodePointer stmt, SymNodePointer x, ASTNodePointer list); // 语句可以向量化，list 为循环体
+    ASTNodePointer Lower(ASTNodePointer stmt, ASTNodePointer x, ASTNodePointer len); // 对应的向量内建函数调用
+    bool IsElem(ASTNodePointer exp, SymNodePointer x);     // 不需要越界检查的 a[x]
+    bool IsVar(ASTNodePointer exp, SymNodePointer sym);    // 变量 sym
+    int Count(ASTNodePointer subTree, SymNodePointer sym); // sym 出现的次数
+    ASTNodePointer MakeCall(const Token &tk, const string &name, ASTNodePointer args);
+    ASTNodePointer MakeArr(const Token &tk, SymNodePointer arr);
+};
+
+#endif
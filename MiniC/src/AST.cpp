@@ -1,40 +1,33 @@
 #include "AST.h"
+#include <algorithm>
+#include <type_traits>
+
+// 内存池释放时不调用结点的析构函数
+static_assert(std::is_trivially_destructible_v<ASTNode>);
+static_assert(sizeof(Token) == 16 && sizeof(ASTNode) <= 64);
 
 ASTNode::ASTNode()
 {
-	this->InitChild();
 }
 
 ASTNode::ASTNode(Token tk, StmtType st) : token(tk), stmtType(st)
 {
-	this->InitChild();
 }
 ASTNode::ASTNode(Token tk) : token(tk), stmtType(StmtType::NONE)
 {
-	this->InitChild();
 }
 
 ASTNode::ASTNode(StmtType st) : stmtType(st)
 {
-	this->InitChild();
 }
 
-ASTNode::~ASTNode()
+void *ASTNode::operator new(size_t size)
 {
-	if (this->child != nullptr)
-	{
-		delete[](this->child);
-		this->child = nullptr;
-	}
+	return Arena::Current().Alloc(size, alignof(ASTNode));
 }
 
-void ASTNode::InitChild()
+void ASTNode::operator delete(void *)
 {
-	this->child = new ASTNodePointer[ASTNode::MAXCHILD]{nullptr};
-	// for (auto idx = 0; idx < this->MAXCHILD; ++idx)
-	// {
-	// 	this->child[idx] = nullptr;
-	// }
 }
 
 void ASTNode::AddSibling(ASTNodePointer node)
@@ -56,6 +49,26 @@ void ASTNode::AddSibling(ASTNodePointer node)
 		}
 	}
 }
+void ASTNode::Append(ASTNodePointer &head, ASTNodePointer &tail, ASTNodePointer node)
+{
+	if (node == nullptr)
+	{
+		return;
+	}
+	if (head == nullptr)
+	{
+		head = node;
+	}
+	else
+	{
+		tail->sibling = node;
+	}
+	// node 本身可能带有兄弟结点，每个结点只被经过一次
+	for (tail = node; tail->sibling != nullptr; tail = tail->sibling)
+	{
+	}
+}
+
 void ASTNode::AddChild(ASTNodePointer node)
 {
 	if (this->childIdx < ASTNode::MAXCHILD)
@@ -82,27 +95,37 @@ bool ASTNode::IsTypeOf(const ExpType &et)
 	return this->expType == et;
 }
 
-AST::~AST()
+bool ASTNode::HasAttr(int a)
 {
-	this->Destroy(root);
-	this->root = nullptr;
+	return (this->attr & a) == a;
 }
 
-void AST::Destroy(ASTNodePointer tree)
+ASTNodePointer ASTNode::Clone()
 {
-	if (tree != nullptr)
+	ASTNodePointer node = new ASTNode(this->token, this->stmtType);
+	node->expType = this->expType;
+	node->symbol_ptr = this->symbol_ptr;
+	node->attr = this->attr;
+	node->childIdx = this->childIdx;
+	for (auto idx = 0; idx < ASTNode::MAXCHILD; ++idx)
 	{
-		if (tree->child != nullptr)
+		// 子结点连同其兄弟结点一起复制
+		ASTNodePointer tail = nullptr;
+		for (auto ptr = this->child[idx]; ptr != nullptr; ptr = ptr->sibling)
 		{
-			for (auto idx = 0; idx < ASTNode::MAXCHILD; ++idx)
+			ASTNodePointer copy = ptr->Clone();
+			if (tail == nullptr)
+			{
+				node->child[idx] = copy;
+			}
+			else
 			{
-				Destroy(tree->child[idx]);
+				tail->sibling = copy;
 			}
+			tail = copy;
 		}
-		Destroy(tree->sibling);
-		// printf(tree->token.val.c_str());
-		delete tree;
 	}
+	return node;
 }
 
 void AST::PrintTree()
@@ -126,10 +149,33 @@ string AST::ToString()
 
 void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 {
-	if (subTree == nullptr)
+	// 用显式栈代替递归，很长的语句序列也不会耗尽调用栈。
+	// 一个结点之后要打印的标题行、子结点和兄弟结点按顺序压栈，再整体反转
+	vector<Line> stack{{subTree, indent, nullptr}};
+	while (!stack.empty())
 	{
-		return;
+		Line top = stack.back();
+		stack.pop_back();
+		if (top.title != nullptr)
+		{
+			buf.append(top.indent, ' ').append("|---").append(top.title);
+			continue;
+		}
+		if (top.node == nullptr)
+		{
+			continue;
+		}
+		subTree = top.node;
+		indent = top.indent;
+		size_t mark = stack.size();
+		this->ToString(subTree, buf, indent, stack);
+		stack.push_back({subTree->sibling, indent, nullptr});
+		std::reverse(stack.begin() + mark, stack.end());
 	}
+}
+
+void AST::ToString(ASTNodePointer subTree, string &buf, int indent, vector<Line> &stack)
+{
 	buf.append(indent, ' ').append("|---");
 	auto s_child = subTree->child;
 	auto printChild = true;
@@ -139,7 +185,7 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	case StmtType::VAR_CALL:
 	{
 		buf.append("VAR_CALL: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		printChild = false;
 		break;
@@ -147,7 +193,7 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	case StmtType::NUM:
 	{
 		buf.append("NUM: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		printChild = false;
 		break;
@@ -155,14 +201,14 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	case StmtType::ARR_DECL:
 	{
 		buf.append("ARR_DECL: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		break;
 	}
 	case StmtType::ARR_LEN:
 	{
 		buf.append("ARR_LEN: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		printChild = false;
 		break;
@@ -170,14 +216,14 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	case StmtType::ARR_CALL:
 	{
 		buf.append("ARR_CALL: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		break;
 	}
 	case StmtType::PARAM_INT:
 	{
 		buf.append("INT: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		printChild = false;
 		break;
@@ -185,7 +231,7 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	case StmtType::PARAM_ARR:
 	{
 		buf.append("ARR: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		printChild = false;
 		break;
@@ -193,7 +239,7 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	case StmtType::VAR_DECL:
 	{
 		buf.append("VAR_DECL: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		printChild = false;
 		break;
@@ -201,21 +247,21 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	case StmtType::RELOP:
 	{
 		buf.append("RELOP: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		break;
 	}
 	case StmtType::ADDOP:
 	{
 		buf.append("ADDOP: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		break;
 	}
 	case StmtType::MULOP:
 	{
 		buf.append("MULOP: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		break;
 	}
@@ -224,24 +270,29 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 		buf.append("ASSIGN: \n");
 		break;
 	}
+	case StmtType::ARR_SIZE:
+	{
+		buf.append("ARR_SIZE: ");
+		buf.append(subTree->token.Text());
+		buf.append("\n");
+		printChild = false;
+		break;
+	}
 
 	case StmtType::IF_STMT:
 	{
 		buf.append("IF_STMT: \n");
 		// 条件
-		buf.append(indent + INDENT, ' ').append("|---");
-		buf.append("IF_COND: \n");
-		ToString(s_child[0], buf, indent + INDENT * 2);
+		stack.push_back({nullptr, indent + INDENT, "IF_COND: \n"});
+		stack.push_back({s_child[0], indent + INDENT * 2, nullptr});
 		// 条件为真
-		buf.append(indent + INDENT, ' ').append("|---");
-		buf.append("IF_TRUE: \n");
-		ToString(s_child[1], buf, indent + INDENT * 2);
+		stack.push_back({nullptr, indent + INDENT, "IF_TRUE: \n"});
+		stack.push_back({s_child[1], indent + INDENT * 2, nullptr});
 		// else
 		if (subTree->child[2] != nullptr)
 		{
-			buf.append(indent + INDENT, ' ').append("|---");
-			buf.append("IF_FALSE: \n");
-			ToString(s_child[2], buf, indent + INDENT * 2);
+			stack.push_back({nullptr, indent + INDENT, "IF_FALSE: \n"});
+			stack.push_back({s_child[2], indent + INDENT * 2, nullptr});
 		}
 		printChild = false;
 		break;
@@ -250,20 +301,18 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	{
 		buf.append("ITER_STMT: \n");
 		// 条件
-		buf.append(indent + INDENT, ' ').append("|---");
-		buf.append("ITER_COND: \n");
-		ToString(s_child[0], buf, indent + INDENT * 2);
+		stack.push_back({nullptr, indent + INDENT, "ITER_COND: \n"});
+		stack.push_back({s_child[0], indent + INDENT * 2, nullptr});
 		// 循环体
-		buf.append(indent + INDENT, ' ').append("|---");
-		buf.append("ITER_BODY: \n");
-		ToString(s_child[1], buf, indent + INDENT * 2);
+		stack.push_back({nullptr, indent + INDENT, "ITER_BODY: \n"});
+		stack.push_back({s_child[1], indent + INDENT * 2, nullptr});
 		printChild = false;
 		break;
 	}
 	case StmtType::FUNC_CALL:
 	{
 		buf.append("FUNC_CALL: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		// 实参列表
 		buf.append(indent + INDENT, ' ').append("|---");
@@ -274,7 +323,7 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 		else
 		{
 			buf.append("ARGS: \n");
-			ToString(s_child[0], buf, indent + INDENT * 2);
+			stack.push_back({s_child[0], indent + INDENT * 2, nullptr});
 		}
 		printChild = false;
 		break;
@@ -282,12 +331,12 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	case StmtType::FUNC_DECL:
 	{ //函数名
 		buf.append("FUNC_DECL: ");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		//返回值
 		buf.append(indent + INDENT, ' ').append("|---");
 		buf.append("RETURN_TYPE: ");
-		buf.append(s_child[0]->token.val);
+		buf.append(s_child[0]->token.Text());
 		buf.append("\n");
 
 		//参数
@@ -299,17 +348,16 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 		else
 		{
 			buf.append("PARAM: \n");
-			ToString(s_child[1], buf, indent + INDENT * 2);
+			stack.push_back({s_child[1], indent + INDENT * 2, nullptr});
 		}
-		// 函数体
-		buf.append(indent + INDENT, ' ').append("|---");
+		// 函数体在参数之后打印
 		if (s_child[2] == nullptr)
 		{
-			buf.append("FUNC_BODY: EMPTY\n");
+			stack.push_back({nullptr, indent + INDENT, "FUNC_BODY: EMPTY\n"});
 			break;
 		}
-		buf.append("FUNC_BODY: \n");
-		ToString(s_child[2], buf, indent + INDENT * 2);
+		stack.push_back({nullptr, indent + INDENT, "FUNC_BODY: \n"});
+		stack.push_back({s_child[2], indent + INDENT * 2, nullptr});
 		printChild = false;
 		break;
 	}
@@ -321,7 +369,7 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 			break;
 		}
 		buf.append("RETURN: \n");
-		ToString(s_child[0], buf, indent + INDENT);
+		stack.push_back({s_child[0], indent + INDENT, nullptr});
 		printChild = false;
 		break;
 	}
@@ -341,7 +389,7 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	{
 		// 打印错误
 		buf.append("???");
-		buf.append(subTree->token.val);
+		buf.append(subTree->token.Text());
 		buf.append("\n");
 		break;
 	}
@@ -350,8 +398,7 @@ void AST::ToString(ASTNodePointer subTree, string &buf, int indent)
 	{
 		for (auto idx = 0; idx < ASTNode::MAXCHILD; ++idx)
 		{
-			ToString(s_child[idx], buf, indent + INDENT);
+			stack.push_back({s_child[idx], indent + INDENT, nullptr});
 		}
 	}
-	ToString(subTree->sibling, buf, indent);
 }
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include "Arena.h"
+#include <algorithm>
+#include <cstdint>
+
+Arena::Scope::Scope(Arena &arena) : saved(Arena::current)
+{
+    Arena::current = &arena;
+}
+
+Arena::Scope::~Scope()
+{
+    Arena::current = this->saved;
+}
+
+Arena::~Arena()
+{
+    this->Release();
+    for (auto &b : this->blocks)
+    {
+        delete[] b.first;
+    }
+    this->blocks.clear();
+}
+
+void *Arena::Alloc(size_t size, size_t align, Destructor destruct)
+{
+    auto addr = reinterpret_cast<uintptr_t>(this->cur);
+    auto aligned = (addr + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    if (this->cur == nullptr || aligned + size > reinterpret_cast<uintptr_t>(this->end))
+    {
+        this->Grow(size + align);
+        addr = reinterpret_cast<uintptr_t>(this->cur);
+        aligned = (addr + align - 1) & ~static_cast<uintptr_t>(align - 1);
+    }
+    char *ptr = reinterpret_cast<char *>(aligned);
+    this->cur = ptr + size;
+    this->used += size;
+    if (destruct != nullptr)
+    {
+        this->destructs.emplace_back(destruct, ptr);
+    }
+    return ptr;
+}
+
+void Arena::Release()
+{
+    // 后分配的对象可能引用先分配的对象，逆序析构
+    for (auto it = this->destructs.rbegin(); it != this->destructs.rend(); ++it)
+    {
+        it->first(it->second);
+    }
+    this->destructs.clear();
+    for (size_t i = 1; i < this->blocks.size(); ++i)
+    {
+        delete[] this->blocks[i].first;
+    }
+    this->blocks.resize(std::min<size_t>(this->blocks.size(), 1));
+    this->cur = this->blocks.empty() ? nullptr : this->blocks[0].first;
+    this->end = this->blocks.empty() ? nullptr : this->blocks[0].first + this->blocks[0].second;
+    this->used = 0;
+}
+
+size_t Arena::Used() const
+{
+    return this->used;
+}
+
+Arena &Arena::Current()
+{
+    static Arena global;
+    return (Arena::current != nullptr) ? *Arena::current : global;
+}
+
+void Arena::Grow(size_t size)
+{
+    size = std::max(size, BLOCK);
+    char *block = new char[size];
+    this->blocks.emplace_back(block, size);
+    this->cur = block;
+    this->end = block + size;
+}
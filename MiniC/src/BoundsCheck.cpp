@@ -0,0 +1,828 @@
+#include "BoundsCheck.h"
+#include <climits>
+#include <algorithm>
+
+Interval::Interval() : lo(INT_MIN), hi(INT_MAX) {}
+
+bool Interval::IsTop() const
+{
+    return lo <= INT_MIN && hi >= INT_MAX;
+}
+
+Interval Interval::Fit(long long l, long long h)
+{
+    if (l < INT_MIN || h > INT_MAX)
+    {
+        // 运算可能溢出，结果未知
+        return Interval();
+    }
+    return Interval(l, h);
+}
+
+Interval RangeState::Get(SymNodePointer sym) const
+{
+    auto iter = this->vars.find(sym);
+    return (iter == this->vars.end()) ? Interval() : iter->second;
+}
+
+void RangeState::Set(SymNodePointer sym, const Interval &v)
+{
+    if (v.IsTop())
+    {
+        this->vars.erase(sym);
+    }
+    else
+    {
+        this->vars[sym] = v;
+    }
+}
+
+RangeState RangeState::Join(const RangeState &a, const RangeState &b)
+{
+    if (a.dead)
+    {
+        return b;
+    }
+    if (b.dead)
+    {
+        return a;
+    }
+    RangeState st;
+    for (auto &v : a.vars)
+    {
+        auto iter = b.vars.find(v.first);
+        if (iter != b.vars.end())
+        {
+            st.Set(v.first, Interval(std::min(v.second.lo, iter->second.lo), std::max(v.second.hi, iter->second.hi)));
+        }
+    }
+    return st;
+}
+
+RangeState RangeState::Widen(const RangeState &a, const RangeState &b)
+{
+    if (a.dead || b.dead)
+    {
+        return b;
+    }
+    RangeState st;
+    for (auto &v : b.vars)
+    {
+        Interval w = v.second;
+        auto iter = a.vars.find(v.first);
+        if (iter != a.vars.end())
+        {
+            // 边界继续扩大的直接推到int的边界
+            w.lo = (w.lo < iter->second.lo) ? INT_MIN : w.lo;
+            w.hi = (w.hi > iter->second.hi) ? INT_MAX : w.hi;
+        }
+        st.Set(v.first, w);
+    }
+    return st;
+}
+
+void BoundsCheck::Run(AST &ast)
+{
+    for (auto ptr = ast.root; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (ptr->IsTypeOf(StmtType::FUNC_DECL))
+        {
+            RangeState st;
+            this->Stmt(ptr->child[2], st, true);
+        }
+    }
+}
+
+void BoundsCheck::StmtList(ASTNodePointer list, RangeState &st, bool annotate)
+{
+    for (auto ptr = list; ptr != nullptr; ptr = ptr->sibling)
+    {
+        this->Stmt(ptr, st, annotate);
+    }
+}
+
+void BoundsCheck::Stmt(ASTNodePointer subTree, RangeState &st, bool annotate)
+{
+    if (subTree == nullptr)
+    {
+        return;
+    }
+    auto child = subTree->child;
+    switch (subTree->stmtType)
+    {
+    case StmtType::IF_STMT:
+    {
+        this->Eval(child[0], st, annotate);
+        RangeState t = st;
+        RangeState f = st;
+        this->Refine(child[0], t, true);
+        this->Stmt(child[1], t, annotate);
+        this->Refine(child[0], f, false);
+        this->Stmt(child[2], f, annotate);
+        st = RangeState::Join(t, f);
+        break;
+    }
+    case StmtType::ITER_STMT:
+    {
+        this->Loop(subTree, st, annotate);
+        break;
+    }
+    case StmtType::RET_STMT:
+    {
+        this->Eval(child[0], st, annotate);
+        st.dead = true;
+        break;
+    }
+    case StmtType::COMP_STMT:
+    {
+        // 进入语句块时，块内声明的变量未初始化
+        for (auto decl = child[0]; decl != nullptr; decl = decl->sibling)
+        {
+            st.vars.erase(decl->symbol_ptr);
+        }
+        this->StmtList(child[1], st, annotate);
+        break;
+    }
+    default:
+    {
+        this->Eval(subTree, st, annotate);
+        break;
+    }
+    }
+}
+
+void BoundsCheck::Loop(ASTNodePointer subTree, RangeState &st, bool annotate)
+{
+    auto cond = subTree->child[0];
+    auto body = subTree->child[1];
+    RangeState entry = st;
+    RangeState head = st;
+
+    // 求循环头的不动点
+    bool stable = false;
+    for (int iter = 0; iter < BoundsCheck::MAX_ITER && !stable; ++iter)
+    {
+        RangeState s = head;
+        this->Eval(cond, s, false);
+        this->Refine(cond, s, true);
+        this->Stmt(body, s, false);
+        RangeState next = RangeState::Join(entry, s);
+        if (iter >= BoundsCheck::WIDEN_AFTER)
+        {
+            next = RangeState::Widen(head, next);
+        }
+        stable = (next == head);
+        head = next;
+    }
+    if (!stable)
+    {
+        head = RangeState();
+    }
+
+    if (annotate)
+    {
+        RangeState s = head;
+        this->Eval(cond, s, true);
+        this->Refine(cond, s, true);
+        this->Stmt(body, s, true);
+    }
+
+    // 循环出口
+    st = head;
+    this->Eval(cond, st, false);
+    this->Refine(cond, st, false);
+
+    if (annotate && this->mode != IR::BOUNDS_NONE && this->Version(subTree, entry))
+    {
+        this->versioned += 1;
+    }
+}
+
+Interval BoundsCheck::Eval(ASTNodePointer subTree, RangeState &st, bool annotate)
+{
+    if (subTree == nullptr)
+    {
+        return Interval();
+    }
+    auto child = subTree->child;
+    switch (subTree->stmtType)
+    {
+    case StmtType::NUM:
+    {
+        try
+        {
+            long long v = subTree->token.Value();
+            return Interval::Fit(v, v);
+        }
+        catch (const std::exception &)
+        {
+            return Interval();
+        }
+    }
+    case StmtType::VAR_CALL:
+    {
+        return IsTracked(subTree->symbol_ptr) ? st.Get(subTree->symbol_ptr) : Interval();
+    }
+    case StmtType::ARR_CALL:
+    {
+        Interval idx = this->Eval(child[0], st, annotate);
+        if (annotate)
+        {
+            this->Annotate(subTree, idx, st);
+        }
+        return Interval();
+    }
+    case StmtType::FUNC_CALL:
+    {
+        for (auto arg = child[0]; arg != nullptr; arg = arg->sibling)
+        {
+            this->Eval(arg, st, annotate);
+        }
+        return Interval();
+    }
+    case StmtType::ARR_SIZE:
+    {
+        return Interval(0, INT_MAX);
+    }
+    case StmtType::ADDOP:
+    {
+        Interval l = (child[0] != nullptr) ? this->Eval(child[0], st, annotate) : Interval(0, 0);
+        Interval r = this->Eval(child[1], st, annotate);
+        if (subTree->token.IsTypeOf(TokenType::PLUS))
+        {
+            return Interval::Fit(l.lo + r.lo, l.hi + r.hi);
+        }
+        return Interval::Fit(l.lo - r.hi, l.hi - r.lo);
+    }
+    case StmtType::MULOP:
+    {
+        Interval l = this->Eval(child[0], st, annotate);
+        Interval r = this->Eval(child[1], st, annotate);
+        bool div = subTree->token.IsTypeOf(TokenType::DIVISION);
+        if (annotate && div)
+        {
+            // 被除数非负时除以2的幂可以用移位代替
+            subTree->attr &= ~ASTNode::ATTR_NONNEG;
+            if (l.lo >= 0 || st.dead)
+            {
+                subTree->attr |= ASTNode::ATTR_NONNEG;
+            }
+        }
+        if (div && r.lo <= 0 && r.hi >= 0)
+        {
+            return Interval();
+        }
+        long long v[4];
+        v[0] = div ? l.lo / r.lo : l.lo * r.lo;
+        v[1] = div ? l.lo / r.hi : l.lo * r.hi;
+        v[2] = div ? l.hi / r.lo : l.hi * r.lo;
+        v[3] = div ? l.hi / r.hi : l.hi * r.hi;
+        return Interval::Fit(*std::min_element(v, v + 4), *std::max_element(v, v + 4));
+    }
+    case StmtType::RELOP:
+    {
+        this->Eval(child[0], st, annotate);
+        this->Eval(child[1], st, annotate);
+        return Interval(0, 1);
+    }
+    case StmtType::ASSIGN_STMT:
+    {
+        // 先计算右值，再计算左值
+        Interval v = this->Eval(child[1], st, annotate);
+        auto left = child[0];
+        if (left != nullptr && left->IsTypeOf(StmtType::VAR_CALL) && IsTracked(left->symbol_ptr))
+        {
+            st.Set(left->symbol_ptr, v);
+        }
+        else
+        {
+            this->Eval(left, st, annotate);
+        }
+        return v;
+    }
+    default:
+        break;
+    }
+    return Interval();
+}
+
+void BoundsCheck::Refine(ASTNodePointer cond, RangeState &st, bool truth)
+{
+    if (cond == nullptr || st.dead || !IsPure(cond))
+    {
+        return;
+    }
+    if (!cond->IsTypeOf(StmtType::RELOP))
+    {
+        // while (x) 为假时 x == 0
+        if (!truth && cond->IsTypeOf(StmtType::VAR_CALL) && IsTracked(cond->symbol_ptr))
+        {
+            this->Restrict(st, cond->symbol_ptr, TokenType::EQ, Interval(0, 0));
+        }
+        return;
+    }
+
+    TokenType op = cond->token.type;
+    if (!truth)
+    {
+        // 取反
+        switch (op)
+        {
+        case TokenType::LT:
+            op = TokenType::GE;
+            break;
+        case TokenType::LE:
+            op = TokenType::GT;
+            break;
+        case TokenType::GT:
+            op = TokenType::LE;
+            break;
+        case TokenType::GE:
+            op = TokenType::LT;
+            break;
+        case TokenType::EQ:
+            op = TokenType::NE;
+            break;
+        case TokenType::NE:
+            op = TokenType::EQ;
+            break;
+        default:
+            return;
+        }
+    }
+    // 交换左右操作数后的运算符
+    TokenType swapped = op;
+    switch (op)
+    {
+    case TokenType::LT:
+        swapped = TokenType::GT;
+        break;
+    case TokenType::LE:
+        swapped = TokenType::GE;
+        break;
+    case TokenType::GT:
+        swapped = TokenType::LT;
+        break;
+    case TokenType::GE:
+        swapped = TokenType::LE;
+        break;
+    default:
+        break;
+    }
+
+    auto left = cond->child[0];
+    auto right = cond->child[1];
+    RangeState tmp = st;
+    Interval l = this->Eval(left, tmp, false);
+    Interval r = this->Eval(right, tmp, false);
+    if (op != TokenType::EQ && op != TokenType::NE && (l.lo - r.hi < INT_MIN || l.hi - r.lo > INT_MAX))
+    {
+        // 虚拟机用回绕的减法比较大小，差可能溢出时结果与数学上的大小关系不一致，不能收窄
+        return;
+    }
+    if (left != nullptr && left->IsTypeOf(StmtType::VAR_CALL) && IsTracked(left->symbol_ptr))
+    {
+        this->Restrict(st, left->symbol_ptr, op, r);
+    }
+    if (right != nullptr && right->IsTypeOf(StmtType::VAR_CALL) && IsTracked(right->symbol_ptr))
+    {
+        this->Restrict(st, right->symbol_ptr, swapped, l);
+    }
+}
+
+void BoundsCheck::Restrict(RangeState &st, SymNodePointer sym, TokenType op, const Interval &r)
+{
+    if (st.dead)
+    {
+        return;
+    }
+    Interval x = st.Get(sym);
+    switch (op)
+    {
+    case TokenType::LT:
+        x.hi = std::min(x.hi, r.hi - 1);
+        break;
+    case TokenType::LE:
+        x.hi = std::min(x.hi, r.hi);
+        break;
+    case TokenType::GT:
+        x.lo = std::max(x.lo, r.lo + 1);
+        break;
+    case TokenType::GE:
+        x.lo = std::max(x.lo, r.lo);
+        break;
+    case TokenType::EQ:
+        x.lo = std::max(x.lo, r.lo);
+        x.hi = std::min(x.hi, r.hi);
+        break;
+    case TokenType::NE:
+        if (r.lo == r.hi)
+        {
+            x.lo += (x.lo == r.lo) ? 1 : 0;
+            x.hi -= (x.hi == r.hi) ? 1 : 0;
+        }
+        break;
+    default:
+        break;
+    }
+    if (x.IsEmpty())
+    {
+        // 条件不可能成立
+        st.dead = true;
+        return;
+    }
+    st.Set(sym, x);
+}
+
+void BoundsCheck::Annotate(ASTNodePointer subTree, const Interval &idx, const RangeState &st)
+{
+    subTree->attr &= ~(ASTNode::ATTR_LOW_SAFE | ASTNode::ATTR_HIGH_SAFE);
+    if (st.dead)
+    {
+        // 不可达的访问
+        subTree->attr |= ASTNode::ATTR_LOW_SAFE | ASTNode::ATTR_HIGH_SAFE;
+        return;
+    }
+    if (idx.lo >= 0)
+    {
+        subTree->attr |= ASTNode::ATTR_LOW_SAFE;
+    }
+    int size = subTree->symbol_ptr->GetArrSize();
+    if (size > 0 && idx.hi < size)
+    {
+        subTree->attr |= ASTNode::ATTR_HIGH_SAFE;
+    }
+}
+
+int BoundsCheck::NeedCheck(ASTNodePointer subTree)
+{
+    int need = 0;
+    if (this->mode != IR::BOUNDS_NONE && !subTree->HasAttr(ASTNode::ATTR_LOW_SAFE))
+    {
+        need |= ASTNode::ATTR_LOW_SAFE;
+    }
+    if (this->mode == IR::BOUNDS_FULL && !subTree->HasAttr(ASTNode::ATTR_HIGH_SAFE))
+    {
+        need |= ASTNode::ATTR_HIGH_SAFE;
+    }
+    return need;
+}
+
+bool BoundsCheck::Version(ASTNodePointer loop, const RangeState &entry)
+{
+    auto cond = loop->child[0];
+    auto body = loop->child[1];
+    if (cond == nullptr || body == nullptr || !cond->IsTypeOf(StmtType::RELOP))
+    {
+        return false;
+    }
+
+    // 循环条件归一化为 x < e 或 x <= e
+    ASTNodePointer x = cond->child[0];
+    ASTNodePointer e = cond->child[1];
+    TokenType op = cond->token.type;
+    if (op == TokenType::GT || op == TokenType::GE)
+    {
+        std::swap(x, e);
+        op = (op == TokenType::GT) ? TokenType::LT : TokenType::LE;
+    }
+    if (op != TokenType::LT && op != TokenType::LE)
+    {
+        return false;
+    }
+    if (x == nullptr || e == nullptr || !x->IsTypeOf(StmtType::VAR_CALL) || !IsTracked(x->symbol_ptr))
+    {
+        return false;
+    }
+    SymNodePointer xs = x->symbol_ptr;
+    bool eNum = e->IsTypeOf(StmtType::NUM);
+    if (!eNum && !(e->IsTypeOf(StmtType::VAR_CALL) && IsTracked(e->symbol_ptr) && e->symbol_ptr != xs))
+    {
+        return false;
+    }
+    if (!eNum && this->CountAssign(body, e->symbol_ptr) > 0)
+    {
+        // 循环边界在循环内被修改
+        return false;
+    }
+
+    // 循环体顶层必须恰好有一条 x = x + c (c > 0) 语句修改x
+    ASTNodePointer list = body->IsTypeOf(StmtType::COMP_STMT) ? body->child[1] : body;
+    int inc = -1;
+    long long c = 0;
+    int k = 0;
+    for (auto ptr = list; ptr != nullptr; ptr = ptr->sibling, ++k)
+    {
+        if (!ptr->IsTypeOf(StmtType::ASSIGN_STMT) || ptr->child[0] == nullptr ||
+            !ptr->child[0]->IsTypeOf(StmtType::VAR_CALL) || ptr->child[0]->symbol_ptr != xs)
+        {
+            continue;
+        }
+        auto rhs = ptr->child[1];
+        if (rhs == nullptr || !rhs->IsTypeOf(StmtType::ADDOP) || !rhs->token.IsTypeOf(TokenType::PLUS) ||
+            rhs->child[0] == nullptr || rhs->child[1] == nullptr)
+        {
+            continue;
+        }
+        for (int side = 0; side < 2; ++side)
+        {
+            auto v = rhs->child[side];
+            auto n = rhs->child[1 - side];
+            if (v->IsTypeOf(StmtType::VAR_CALL) && v->symbol_ptr == xs && n->IsTypeOf(StmtType::NUM))
+            {
+                inc = k;
+                c = n->token.Value();
+            }
+        }
+    }
+    if (inc < 0 || c <= 0 || c > INT_MAX || this->CountAssign(body, xs) != 1 || this->CountAssign(cond, xs) != 0)
+    {
+        return false;
+    }
+
+    // 收集下标形如 x + d 且仍需检查的数组访问
+    // 自增语句之后的访问，下标的最大值还要加上c
+    vector<ASTNodePointer> cand;
+    vector<int> need;
+    long long dmin = LLONG_MAX;
+    map<SymNodePointer, long long> kmax;
+    k = 0;
+    for (auto ptr = list; ptr != nullptr; ptr = ptr->sibling, ++k)
+    {
+        vector<ASTNodePointer> access;
+        this->CollectAccess(ptr, access);
+        for (auto a : access)
+        {
+            long long d = 0;
+            int n = this->NeedCheck(a);
+            if (n == 0 || !this->IndexOffset(a->child[0], xs, d))
+            {
+                continue;
+            }
+            if (n & ASTNode::ATTR_LOW_SAFE)
+            {
+                dmin = std::min(dmin, d);
+            }
+            if (n & ASTNode::ATTR_HIGH_SAFE)
+            {
+                long long shift = (k > inc) ? c : 0;
+                auto iter = kmax.find(a->symbol_ptr);
+                kmax[a->symbol_ptr] = (iter == kmax.end()) ? d + shift : std::max(iter->second, d + shift);
+            }
+            cand.push_back(a);
+            need.push_back(n);
+        }
+    }
+    if (cand.empty())
+    {
+        return false;
+    }
+
+    Interval xr = entry.Get(xs);
+    Interval er = eNum ? this->Eval(e, const_cast<RangeState &>(entry), false) : entry.Get(e->symbol_ptr);
+    vector<ASTNodePointer> guards;
+    int safe = 0;
+
+    // 下界: 进入循环时 x + dmin >= 0，之后x只增不减
+    if (dmin != LLONG_MAX)
+    {
+        if (xr.lo + dmin < 0)
+        {
+            guards.push_back(this->MakeOp(loop->token, StmtType::RELOP, TokenType::GE, x->Clone(), this->MakeNum(loop->token, -dmin)));
+        }
+        safe |= ASTNode::ATTR_LOW_SAFE;
+    }
+
+    // 上界: 下标最大值为 e - 1 + k (x < e) 或 e + k (x <= e)，要求小于数组长度
+    map<SymNodePointer, bool> highOk;
+    for (auto &item : kmax)
+    {
+        auto arr = item.first;
+        long long adj = item.second + ((op == TokenType::LE) ? 1 : 0);
+        int size = arr->GetArrSize();
+        if (size > 0)
+        {
+            long long bound = size - adj;
+            if (er.hi <= bound)
+            {
+                highOk[arr] = true;
+            }
+            else if (!eNum)
+            {
+                guards.push_back(this->MakeOp(loop->token, StmtType::RELOP, TokenType::LE, e->Clone(), this->MakeNum(loop->token, bound)));
+                highOk[arr] = true;
+            }
+        }
+        else if (arr->IsParam())
+        {
+            // 数组形参的长度在运行时读取
+            ASTNodePointer len = new ASTNode(Token(TokenType::ID, arr->token_ptr->Text()), StmtType::ARR_SIZE);
+            len->symbol_ptr = arr;
+            len->expType = ExpType::INT;
+            if (adj != 0)
+            {
+                len = this->MakeOp(loop->token, StmtType::ADDOP, TokenType::MINUS, len, this->MakeNum(loop->token, adj));
+            }
+            guards.push_back(this->MakeOp(loop->token, StmtType::RELOP, TokenType::LE, e->Clone(), len));
+            highOk[arr] = true;
+        }
+    }
+
+    // 没有上界约束时，还要保证 x + c 不会溢出
+    if (highOk.empty())
+    {
+        long long limit = INT_MAX - c + ((op == TokenType::LT) ? 1 : 0);
+        if (er.hi > limit)
+        {
+            if (eNum)
+            {
+                return false;
+            }
+            guards.push_back(this->MakeOp(loop->token, StmtType::RELOP, TokenType::LE, e->Clone(), this->MakeNum(loop->token, limit)));
+        }
+    }
+
+    // 标记可以省去检查的访问，生成不带检查的副本
+    vector<int> saved;
+    bool changed = false;
+    for (size_t i = 0; i < cand.size(); ++i)
+    {
+        int bits = need[i] & safe;
+        if (highOk.count(cand[i]->symbol_ptr))
+        {
+            bits |= need[i] & ASTNode::ATTR_HIGH_SAFE;
+        }
+        saved.push_back(cand[i]->attr);
+        cand[i]->attr |= bits;
+        changed = changed || (bits != 0);
+    }
+    if (!changed || guards.empty())
+    {
+        // 条件在编译期已经成立，不需要版本化
+        return false;
+    }
+
+    ASTNodePointer fast = loop->Clone();
+    for (size_t i = 0; i < cand.size(); ++i)
+    {
+        cand[i]->attr = saved[i];
+    }
+
+    // 合并条件: 关系运算的结果为0或1，相乘即为逻辑与
+    ASTNodePointer guard = guards[0];
+    for (size_t i = 1; i < guards.size(); ++i)
+    {
+        guard = this->MakeOp(loop->token, StmtType::MULOP, TokenType::TIMES, guard, guards[i]);
+    }
+
+    // while 结点原地改写为 if (guard) fast-loop else slow-loop
+    ASTNodePointer slow = new ASTNode(loop->token, StmtType::ITER_STMT);
+    slow->AddChild(cond);
+    slow->AddChild(body);
+    loop->stmtType = StmtType::IF_STMT;
+    loop->child[0] = guard;
+    loop->child[1] = fast;
+    loop->child[2] = slow;
+    return true;
+}
+
+bool BoundsCheck::IndexOffset(ASTNodePointer idx, SymNodePointer var, long long &d)
+{
+    if (idx == nullptr)
+    {
+        return false;
+    }
+    if (idx->IsTypeOf(StmtType::VAR_CALL))
+    {
+        d = 0;
+        return idx->symbol_ptr == var;
+    }
+    if (!idx->IsTypeOf(StmtType::ADDOP) || idx->child[0] == nullptr || idx->child[1] == nullptr)
+    {
+        return false;
+    }
+    auto l = idx->child[0];
+    auto r = idx->child[1];
+    bool plus = idx->token.IsTypeOf(TokenType::PLUS);
+    if (l->IsTypeOf(StmtType::VAR_CALL) && l->symbol_ptr == var && r->IsTypeOf(StmtType::NUM))
+    {
+        d = plus ? r->token.Value() : -r->token.Value();
+        return true;
+    }
+    if (plus && r->IsTypeOf(StmtType::VAR_CALL) && r->symbol_ptr == var && l->IsTypeOf(StmtType::NUM))
+    {
+        d = l->token.Value();
+        return true;
+    }
+    return false;
+}
+
+void BoundsCheck::CollectAccess(ASTNodePointer subTree, vector<ASTNodePointer> &access)
+{
+    if (subTree == nullptr)
+    {
+        return;
+    }
+    if (subTree->IsTypeOf(StmtType::ARR_CALL))
+    {
+        access.push_back(subTree);
+    }
+    for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+    {
+        for (auto ptr = subTree->child[i]; ptr != nullptr; ptr = ptr->sibling)
+        {
+            this->CollectAccess(ptr, access);
+        }
+    }
+}
+
+int BoundsCheck::CountAssign(ASTNodePointer subTree, SymNodePointer sym)
+{
+    if (subTree == nullptr)
+    {
+        return 0;
+    }
+    int count = 0;
+    if (subTree->IsTypeOf(StmtType::ASSIGN_STMT) && subTree->child[0] != nullptr &&
+        subTree->child[0]->symbol_ptr == sym)
+    {
+        count += 1;
+    }
+    for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+    {
+        for (auto ptr = subTree->child[i]; ptr != nullptr; ptr = ptr->sibling)
+        {
+            count += this->CountAssign(ptr, sym);
+        }
+    }
+    return count;
+}
+
+ASTNodePointer BoundsCheck::MakeNum(const Token &tk, long long v)
+{
+    Token t(TokenType::NUM, std::to_string(v));
+    t.row = tk.row;
+    t.col = tk.col;
+    ASTNodePointer node = new ASTNode(t, StmtType::NUM);
+    node->expType = ExpType::NUM;
+    return node;
+}
+
+ASTNodePointer BoundsCheck::MakeOp(const Token &tk, StmtType st, TokenType op, ASTNodePointer l, ASTNodePointer r)
+{
+    string val;
+    switch (op)
+    {
+    case TokenType::LE:
+        val = "<=";
+        break;
+    case TokenType::GE:
+        val = ">=";
+        break;
+    case TokenType::MINUS:
+        val = "-";
+        break;
+    case TokenType::TIMES:
+        val = "*";
+        break;
+    default:
+        break;
+    }
+    Token t(op, val);
+    t.row = tk.row;
+    t.col = tk.col;
+    ASTNodePointer node = new ASTNode(t, st);
+    node->expType = ExpType::INT;
+    node->AddChild(l);
+    node->AddChild(r);
+    return node;
+}
+
+bool BoundsCheck::IsTracked(SymNodePointer sym)
+{
+    // 数组和全局变量不参与分析，局部变量不会被其他函数修改
+    return sym != nullptr && sym->IsVar() && !sym->IsGlobal();
+}
+
+bool BoundsCheck::IsPure(ASTNodePointer subTree)
+{
+    if (subTree == nullptr)
+    {
+        return true;
+    }
+    if (subTree->IsTypeOf(StmtType::ASSIGN_STMT) || subTree->IsTypeOf(StmtType::FUNC_CALL))
+    {
+        return false;
+    }
+    for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+    {
+        for (auto ptr = subTree->child[i]; ptr != nullptr; ptr = ptr->sibling)
+        {
+            if (!IsPure(ptr))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
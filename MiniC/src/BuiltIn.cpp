@@ -0,0 +1,47 @@
+#include "BuiltIn.h"
+
+const vector<BuiltIn> BuiltIn::TABLE =
+    {
+        // 按元素运算的循环向量化后生成
+        {"_vadd", SymType::VOID, "AAAII", "VADD", true},   // c[i..i+n) = a[..] + b[..]
+        {"_vsub", SymType::VOID, "AAAII", "VSUB", true},   // -
+        {"_vmul", SymType::VOID, "AAAII", "VMUL", true},   // *
+        {"_vfill", SymType::VOID, "AIII", "VFILL", true},  // c[i..i+n) = v
+        {"_vcopy", SymType::VOID, "AAII", "VCOPY", true},  // c[i..i+n) = a[..]
+        {"_vsum", SymType::INT, "AII", "VSUM", true},      // a[i] + ... + a[i+n-1]
+
+        // 数组库函数
+        {"arrcopy", SymType::VOID, "AAI", "VCOPY", false}, // arrcopy(dst, src, n)
+        {"arrfill", SymType::VOID, "AII", "VFILL", false}, // arrfill(a, v, n)
+        {"arrsum", SymType::INT, "AI", "VSUM", false},     // arrsum(a, n)
+        {"arrsort", SymType::VOID, "AI", "VSORT", false},  // arrsort(a, n)，升序
+        {"arrmin", SymType::INT, "AI", "VMIN", false},     // arrmin(a, n)，n <= 0 时为0
+        {"arrmax", SymType::INT, "AI", "VMAX", false},     // arrmax(a, n)，n <= 0 时为0
+        {"arrfind", SymType::INT, "AII", "VFIND", false},  // arrfind(a, v, n)，不存在时为-1
+};
+
+bool BuiltIn::HasResult() const
+{
+    return this->rtype == SymType::INT;
+}
+
+const BuiltIn *BuiltIn::Find(SymNodePointer sym)
+{
+    if (sym == nullptr || sym->builtin < 0)
+    {
+        return nullptr;
+    }
+    return &TABLE[sym->builtin];
+}
+
+const BuiltIn *BuiltIn::FindOp(const string &op)
+{
+    for (auto &b : TABLE)
+    {
+        if (b.op == op)
+        {
+            return &b;
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,393 @@
+#include "CFG.h"
+#include <algorithm>
+#include <stack>
+using std::stack;
+
+void CFG::Build(IR &ir)
+{
+    this->ir = &ir;
+    auto &qps = ir.qps;
+    int size = qps.size();
+
+    blocks.clear();
+    funcs.clear();
+    target.assign(size, -1);
+    blockOf.assign(size, -1);
+    removed.assign(size, false);
+
+    // 函数按入口位置排序，入口之前的指令属于启动代码
+    vector<std::pair<int, string>> entries;
+    for (auto &e : ir.inst_offset)
+    {
+        entries.push_back({e.second, e.first});
+    }
+    std::sort(entries.begin(), entries.end());
+    if (entries.empty() || entries.front().first > 0)
+    {
+        entries.insert(entries.begin(), {0, "_start"});
+    }
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        CFGFunc f;
+        f.name = entries[i].second;
+        f.entry = entries[i].first;
+        f.end = (i + 1 < entries.size()) ? entries[i + 1].first : size;
+        f.reachable = true;
+        funcs.push_back(f);
+    }
+
+    // 划分基本块：入口、跳转目标、转移指令的下一条指令为首指令
+    vector<bool> leader(size + 1, false);
+    for (auto &f : funcs)
+    {
+        leader[f.entry] = true;
+    }
+    for (int i = 0; i < size; ++i)
+    {
+        auto &q = qps[i];
+        switch (q.ctrl)
+        {
+        case Quadruple::CTRL_JUMP:
+        {
+            target[i] = i + 1 + std::stoi(q.addr2);
+            leader[i + 1] = true;
+            break;
+        }
+        case Quadruple::CTRL_CALL:
+        case Quadruple::CTRL_TAIL:
+        {
+            target[i] = std::stoi(q.addr2);
+            leader[i + 1] = true;
+            break;
+        }
+        case Quadruple::CTRL_ADDR:
+        {
+            target[i] = std::stoi(q.addr2);
+            break;
+        }
+        case Quadruple::CTRL_RET:
+        case Quadruple::CTRL_HALT:
+        {
+            leader[i + 1] = true;
+            break;
+        }
+        default:
+            break;
+        }
+        if (target[i] >= 0 && target[i] <= size)
+        {
+            leader[target[i]] = true;
+        }
+    }
+
+    int fn = 0;
+    for (int i = 0; i < size; ++i)
+    {
+        while (fn + 1 < static_cast<int>(funcs.size()) && i >= funcs[fn + 1].entry)
+        {
+            ++fn;
+        }
+        if (leader[i] || blocks.empty())
+        {
+            BasicBlock bb;
+            bb.id = blocks.size();
+            bb.begin = i;
+            bb.func = fn;
+            bb.reachable = true;
+            blocks.push_back(bb);
+            funcs[fn].blocks.push_back(bb.id);
+            if (funcs[fn].block < 0)
+            {
+                funcs[fn].block = bb.id;
+            }
+        }
+        blocks.back().end = i + 1;
+        blockOf[i] = blocks.back().id;
+    }
+
+    // 连接基本块
+    for (auto &bb : blocks)
+    {
+        int last = bb.Last();
+        auto &q = qps[last];
+        bool fall = true;
+        switch (q.ctrl)
+        {
+        case Quadruple::CTRL_JUMP:
+        {
+            AddEdge(bb.id, blockOf.at(target[last]));
+            fall = IsCondJump(q);
+            break;
+        }
+        case Quadruple::CTRL_CALL:
+        case Quadruple::CTRL_TAIL:
+        {
+            // 调用结束后返回到下一条指令，尾调用直接返回到调用者
+            fall = (q.ctrl == Quadruple::CTRL_CALL);
+            int callee = FuncOf(target[last]);
+            auto &callees = funcs[bb.func].callees;
+            if (std::find(callees.begin(), callees.end(), callee) == callees.end())
+            {
+                callees.push_back(callee);
+                funcs[callee].callers.push_back(bb.func);
+            }
+            break;
+        }
+        case Quadruple::CTRL_RET:
+        case Quadruple::CTRL_HALT:
+        {
+            fall = false;
+            break;
+        }
+        default:
+            break;
+        }
+        if (fall && bb.end < size && FuncOf(bb.end) == bb.func)
+        {
+            AddEdge(bb.id, blockOf[bb.end]);
+        }
+    }
+}
+
+void CFG::AddEdge(int from, int to)
+{
+    auto &succ = blocks[from].succ;
+    if (std::find(succ.begin(), succ.end(), to) == succ.end())
+    {
+        succ.push_back(to);
+        blocks[to].pred.push_back(from);
+    }
+}
+
+bool CFG::IsCondJump(const Quadruple &q)
+{
+    return q.ctrl == Quadruple::CTRL_JUMP && !q.iop.empty() && q.iop[0] == 'J';
+}
+
+int CFG::FuncOf(int inst) const
+{
+    // funcs 按入口位置有序
+    int lo = 0, hi = funcs.size() - 1;
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+        if (funcs[mid].entry <= inst)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+int CFG::RemoveUnreachable()
+{
+    if (ir == nullptr || blocks.empty())
+    {
+        return 0;
+    }
+    auto &qps = ir->qps;
+    for (auto &bb : blocks)
+    {
+        bb.reachable = false;
+    }
+    for (auto &f : funcs)
+    {
+        f.reachable = false;
+    }
+
+    // 从启动代码出发，沿调用边标记函数，沿控制流边标记基本块
+    stack<int> fs;
+    funcs[FuncOf(0)].reachable = true;
+    fs.push(FuncOf(0));
+    while (!fs.empty())
+    {
+        auto &f = funcs[fs.top()];
+        fs.pop();
+        if (f.block < 0)
+        {
+            continue;
+        }
+        stack<int> bs;
+        blocks[f.block].reachable = true;
+        bs.push(f.block);
+        while (!bs.empty())
+        {
+            auto &bb = blocks[bs.top()];
+            bs.pop();
+            for (int i = bb.begin; i < bb.end; ++i)
+            {
+                if (target[i] < 0 || target[i] >= static_cast<int>(qps.size()))
+                {
+                    continue;
+                }
+                if (qps[i].ctrl == Quadruple::CTRL_CALL || qps[i].ctrl == Quadruple::CTRL_TAIL)
+                {
+                    auto &callee = funcs[FuncOf(target[i])];
+                    if (!callee.reachable)
+                    {
+                        callee.reachable = true;
+                        fs.push(FuncOf(target[i]));
+                    }
+                }
+                else if (qps[i].ctrl == Quadruple::CTRL_ADDR)
+                {
+                    // 返回地址所在的块可以通过返回到达
+                    auto &ret = blocks[blockOf[target[i]]];
+                    if (!ret.reachable)
+                    {
+                        ret.reachable = true;
+                        bs.push(ret.id);
+                    }
+                }
+            }
+            for (auto s : bb.succ)
+            {
+                if (!blocks[s].reachable)
+                {
+                    blocks[s].reachable = true;
+                    bs.push(s);
+                }
+            }
+        }
+    }
+
+    int removed = 0;
+    for (auto &bb : blocks)
+    {
+        if (!bb.reachable)
+        {
+            removed += bb.end - bb.begin;
+        }
+    }
+    return removed;
+}
+
+void CFG::Linearize()
+{
+    if (ir == nullptr)
+    {
+        return;
+    }
+    auto &qps = ir->qps;
+    int size = qps.size();
+
+    // 计算保留指令的新位置
+    vector<int> pos(size + 1, -1);
+    int n = 0;
+    for (auto &bb : blocks)
+    {
+        if (bb.reachable)
+        {
+            for (int i = bb.begin; i < bb.end; ++i)
+            {
+                // 被删除的指令映射到下一条保留的指令
+                pos[i] = n;
+                n += removed[i] ? 0 : 1;
+            }
+        }
+    }
+    pos[size] = n;
+
+    vector<Quadruple> code;
+    code.reserve(n);
+    for (int i = 0; i < size; ++i)
+    {
+        if (pos[i] < 0 || removed[i])
+        {
+            continue;
+        }
+        Quadruple q = qps[i];
+        if (target[i] >= 0)
+        {
+            int t = pos.at(target[i]);
+            switch (q.ctrl)
+            {
+            case Quadruple::CTRL_JUMP:
+            {
+                q.addr2 = to_string(t - pos[i] - 1);
+                break;
+            }
+            case Quadruple::CTRL_CALL:
+            case Quadruple::CTRL_TAIL:
+            case Quadruple::CTRL_ADDR:
+            {
+                q.addr2 = to_string(t);
+                break;
+            }
+            default:
+                break;
+            }
+        }
+        code.push_back(q);
+    }
+
+    // 更新函数入口，删除未被调用的函数
+    for (auto &f : funcs)
+    {
+        auto iter = ir->inst_offset.find(f.name);
+        if (iter == ir->inst_offset.end())
+        {
+            continue;
+        }
+        if (f.reachable)
+        {
+            iter->second = pos[f.entry];
+        }
+        else
+        {
+            ir->inst_offset.erase(iter);
+        }
+    }
+
+    qps.swap(code);
+    this->Build(*ir);
+}
+
+void CFG::PrintCFG()
+{
+    string str = this->ToString();
+    Logger::Print("%.*s", str.size(), str.data());
+}
+
+string CFG::ToString()
+{
+    string buffer;
+    buffer.reserve(1024 * 10);
+    buffer.append("-------------------------------------------\n");
+    buffer.append("Control Flow Graph:\n");
+    buffer.append("-------------------------------------------\n");
+    for (auto &f : funcs)
+    {
+        buffer.append("|---").append(f.name).append(f.reachable ? "" : " (unreachable)").append(": calls");
+        for (auto c : f.callees)
+        {
+            buffer.append(" ").append(funcs[c].name);
+        }
+        buffer.append("\n");
+        for (auto b : f.blocks)
+        {
+            auto &bb = blocks[b];
+            buffer.append(CFG::INDENT, ' ')
+                .append("|---B")
+                .append(to_string(bb.id))
+                .append(" [")
+                .append(to_string(bb.begin))
+                .append(",")
+                .append(to_string(bb.end))
+                .append(")")
+                .append(bb.reachable ? "" : " (unreachable)")
+                .append(" ->");
+            for (auto s : bb.succ)
+            {
+                buffer.append(" B").append(to_string(s));
+            }
+            buffer.append("\n");
+        }
+    }
+    buffer.append("-------------------------------------------\n");
+    return buffer;
+}
@@ -51,6 +51,25 @@ void CLI::Parse(int argc, char **argv)
                 flag |= FLAG_TRACE;
                 break;
             }
+            case 'O':
+            {
+                // -O0/-O1/-O2 优化级别
+                if (arg[2] < '0' || arg[2] > '9' || arg[3] != '\0' || !this->passes.SetLevel(arg[2] - '0'))
+                {
+                    Logger::Print("Unsupport Optimization Level: %s\n", arg);
+                    return;
+                }
+                break;
+            }
+            case '-':
+            {
+                if (!ParseOption(arg + 2))
+                {
+                    Logger::Print("Unsupport Argument: %s\n", arg);
+                    return;
+                }
+                break;
+            }
             case 'h':
             {
                 Logger::Print("Usage:\n");
@@ -60,6 +79,14 @@ void CLI::Parse(int argc, char **argv)
                 Logger::Print("-z: Trace All Step\n");
                 Logger::Print("-c: -c <file.mc> Generate IR Code\n");
                 Logger::Print("-r: -r <file.ir> Run IR Code\n");
+                Logger::Print("--inline-size=N: Inline Functions Up To N Instructions\n");
+                Logger::Print("--inline-leaf=N: Inline Leaf Functions Up To N Instructions\n");
+                Logger::Print("--eval-steps=N: Evaluate At Compile Time Within N Steps\n");
+                Logger::Print("--unroll-factor=N: Unroll Counted Loops N Times (1-16, Default 4)\n");
+                Logger::Print("-O0|-O1|-O2: Optimization Level (Default -O1, -O2 Generates Code Through SSA)\n");
+                Logger::Print("--time-passes: Show Time, Size And Memory Of Each Pass\n");
+                Logger::Print(this->passes.Usage());
+                Logger::Print("--bounds-check[=0|1|2]: Array Bounds Check (0: None, 1: Negative Index, 2: Full)\n");
                 Logger::Print("-h: Show This Document\n");
                 return;
             }
@@ -105,6 +132,63 @@ void CLI::Parse(int argc, char **argv)
     }
 }
 
+bool CLI::ParseOption(const string &opt)
+{
+    size_t pos = opt.find('=');
+    string name = opt.substr(0, pos);
+    int value = (name == "bounds-check") ? IR::BOUNDS_FULL : 0;
+    if (pos != string::npos)
+    {
+        try
+        {
+            value = std::stoi(opt.substr(pos + 1));
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+    }
+
+    if (name == "inline-size")
+    {
+        this->inlineSize = value;
+    }
+    else if (name == "inline-leaf")
+    {
+        this->inlineLeaf = value;
+    }
+    else if (name == "eval-steps")
+    {
+        this->evalSteps = value;
+    }
+    else if (name == "unroll-factor")
+    {
+        if (value < 1 || value > LoopUnroll::MAX_FACTOR)
+        {
+            return false;
+        }
+        this->unrollFactor = value;
+    }
+    else if (name == "bounds-check")
+    {
+        if (value < IR::BOUNDS_NONE || value > IR::BOUNDS_FULL)
+        {
+            return false;
+        }
+        this->boundsCheck = value;
+    }
+    else if (name == "time-passes")
+    {
+        this->passes.timePasses = true;
+    }
+    else
+    {
+        // 单独打开或关闭一遍，--ssa 等同于 --ssa=1
+        return this->passes.Set(name, (pos == string::npos) || (value != 0));
+    }
+    return true;
+}
+
 void CLI::Compile(int flag, const string &filename)
 {
     string suffixStr = filename.substr(filename.size() - 2);
@@ -113,14 +197,28 @@ void CLI::Compile(int flag, const string &filename)
         Logger::Print("Unsupported FileType(.mc): %s\n", filename.c_str());
         exit(-1);
     }
+    // 语法树和符号表在这次编译的内存池中分配，函数返回时整体释放
+    Arena arena;
+    Arena::Scope scope(arena);
     Scanner scanner;
     Parser parser;
     SymTable table;
     IR ir;
+    auto &passes = this->passes;
 
     if (flag & FLAG_SCAN)
     {
-        if ((scanner.Scan(filename)) && (flag & FLAG_TRACE))
+        bool ok = false;
+        if ((flag & FLAG_PARSE) && !(flag & FLAG_TRACE))
+        {
+            // 语法分析时按需扫描记号，这里只读入源文件
+            passes.Time("scan", [&]() { ok = scanner.Open(filename); }, [&]() { return PassManager::Measure(scanner); });
+        }
+        else
+        {
+            passes.Time("scan", [&]() { ok = scanner.Scan(filename); }, [&]() { return PassManager::Measure(scanner); });
+        }
+        if (ok && (flag & FLAG_TRACE))
         {
             std::fstream ofs;
             string tmp = scanner.ToString();
@@ -141,7 +239,9 @@ void CLI::Compile(int flag, const string &filename)
 
     if (flag & FLAG_PARSE)
     {
-        if ((parser.Parse(scanner)) && (flag & FLAG_TRACE))
+        bool ok = false;
+        passes.Time("parse", [&]() { ok = parser.Parse(scanner); }, [&]() { return PassManager::Measure(parser.GetAST()); });
+        if (ok && (flag & FLAG_TRACE))
         {
             AST &ast = parser.GetAST();
             string tmp = ast.ToString();
@@ -156,7 +256,7 @@ void CLI::Compile(int flag, const string &filename)
         }
     }
 
-    if (!parser.FLAG_AST)
+    if (!scanner.FLAG_SCANNER || !parser.FLAG_AST)
     {
         exit(-1);
     }
@@ -164,7 +264,11 @@ void CLI::Compile(int flag, const string &filename)
     if (flag & FLAG_SYMTAB)
     {
         AST &ast = parser.GetAST();
-        if (table.Build(ast) && table.TypeCheck() && (flag & FLAG_TRACE))
+        // 完整检查时数组前多分配一个单元保存长度
+        table.arrayHeader = (this->boundsCheck == IR::BOUNDS_FULL);
+        bool ok = false;
+        passes.Time("symtab", [&]() { ok = table.Build(ast) && table.TypeCheck(); }, [&]() { return PassManager::Measure(ast); });
+        if (ok && (flag & FLAG_TRACE))
         {
             string tmp = table.ToString();
             std::fstream ofs;
@@ -186,7 +290,100 @@ void CLI::Compile(int flag, const string &filename)
     if (flag & FLAG_IR)
     {
         AST &ast = parser.GetAST();
-        ir.GenIR(ast, table);
+        auto astSize = [&]() { return PassManager::Measure(ast); };
+        auto irSize = [&]() { return PassManager::Measure(ir); };
+
+        // 生成代码时使用的优化遍
+        bool inlining = passes.Enabled("inline");
+        ir.inlineSize = inlining ? this->inlineSize : -1;
+        ir.inlineLeaf = inlining ? this->inlineLeaf : -1;
+        ir.licm = passes.Enabled("licm");
+        ir.tailCall = passes.Enabled("tail-call");
+        ir.boundsCheck = this->boundsCheck;
+        FrameLayout layout;
+        passes.Run("frame", [&]() { layout.Run(table); }, astSize);
+        ConstEval ce;
+        ce.steps = this->evalSteps;
+        passes.Run("const-eval", [&]() { ce.Run(ast, table); }, astSize);
+        if (this->boundsCheck != IR::BOUNDS_NONE)
+        {
+            // 消除可以证明不越界的检查
+            BoundsCheck bc;
+            bc.mode = this->boundsCheck;
+            passes.Run("bounds-elim", [&]() { bc.Run(ast); }, astSize);
+        }
+        // 向量化在展开之前，展开会打乱按元素运算的循环
+        Vectorize vec;
+        vec.boundsCheck = this->boundsCheck;
+        passes.Run("vectorize", [&]() { vec.Run(ast, table); }, astSize);
+        LoopUnroll unroll;
+        unroll.factor = this->unrollFactor;
+        passes.Run("unroll", [&]() { unroll.Run(ast); }, astSize);
+        if (passes.Enabled("ssa"))
+        {
+            MIR mir;
+            mir.boundsCheck = this->boundsCheck;
+            auto mirSize = [&]() { return PassManager::Measure(mir); };
+            passes.Time("ssa", [&]() { mir.Build(ast); }, mirSize);
+            passes.Time("gvn", [&]() { mir.GVN(); }, mirSize);
+            if (flag & FLAG_TRACE)
+            {
+                std::fstream ofs;
+                ofs.open(filename + ".mir", std::ios::out);
+                if (ofs.is_open())
+                {
+                    ofs << mir.ToString() << endl;
+                    ofs.close();
+                    Logger::Print("# SSA Mid-level IR Save At %s.mir \n", filename.c_str());
+                }
+            }
+            passes.Time("codegen", [&]() { ir.GenIR(mir, table); }, irSize);
+        }
+        else
+        {
+            passes.Time("codegen", [&]() { ir.GenIR(ast, table); }, irSize);
+        }
+
+        // 线程化跳转，删除不可达代码和未被调用的函数，再删除死存储和结果不被使用的指令
+        CFG cfg;
+        bool thread = passes.Enabled("jump-thread");
+        bool dce = passes.Enabled("dce");
+        bool liveness = passes.Enabled("liveness");
+        auto cfgSize = [&]()
+        {
+            // 只统计保留的指令
+            auto size = PassManager::Measure(ir);
+            for (auto &bb : cfg.blocks)
+            {
+                for (int i = bb.begin; i < bb.end; ++i)
+                {
+                    size.units -= (!bb.reachable || cfg.removed[i]) ? 1 : 0;
+                }
+            }
+            return size;
+        };
+        if (thread || dce || liveness)
+        {
+            passes.Time("cfg", [&]() { cfg.Build(ir); }, irSize);
+            JumpThread jt;
+            passes.Run("jump-thread", [&]() { jt.Run(cfg, ir); }, irSize);
+            passes.Run("dce", [&]() { cfg.RemoveUnreachable(); }, cfgSize);
+            Liveness live;
+            passes.Run("liveness", [&]() { live.Run(cfg, ir, table); }, cfgSize);
+            passes.Time("linearize", [&]() { cfg.Linearize(); }, irSize);
+        }
+        if ((thread || dce || liveness) && (flag & FLAG_TRACE))
+        {
+            std::fstream ofs;
+            ofs.open(filename + ".cfg", std::ios::out);
+            if (ofs.is_open())
+            {
+                ofs << cfg.ToString() << endl;
+                ofs.close();
+                Logger::Print("# Control Flow Graph Save At %s.cfg \n", filename.c_str());
+            }
+        }
+
         string tmp = ir.ToString();
         std::fstream ofs;
         ofs.open(filename + ".ir", std::ios::out);
@@ -197,6 +394,7 @@ void CLI::Compile(int flag, const string &filename)
         }
         Logger::Print("# IR Code Save At %s.ir \n", filename.c_str());
     }
+    passes.PrintTimes();
 }
 
 void CLI::Run(const string &filename)
@@ -0,0 +1,683 @@
+#include "ConstEval.h"
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+
+int ConstEval::Run(AST &ast, SymTable &table)
+{
+    this->folded = 0;
+    this->program = false;
+    this->budget = this->steps * BUDGET_TIMES;
+    this->funcs.clear();
+    this->cache.clear();
+
+    auto global = table.symtab;
+    for (auto ptr = global->scope; ptr != nullptr && ptr != global; ptr = ptr->next)
+    {
+        if (ptr->IsFunc() && ptr->builtin == SymNode::OUTPUT)
+        {
+            this->outputSym = ptr;
+        }
+    }
+    ASTNodePointer main = nullptr;
+    for (auto ptr = ast.root; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (ptr->IsTypeOf(StmtType::FUNC_DECL))
+        {
+            this->funcs[ptr->token.id] = ptr;
+            main = (ptr->token.Text() == "main") ? ptr : main;
+        }
+    }
+
+    if (main != nullptr && this->Program(main))
+    {
+        this->program = true;
+        return this->folded;
+    }
+    for (auto ptr = ast.root; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (ptr->IsTypeOf(StmtType::FUNC_DECL))
+        {
+            this->Fold(ptr->child[2]);
+        }
+    }
+    return this->folded;
+}
+
+bool ConstEval::Program(ASTNodePointer main)
+{
+    if (this->outputSym == nullptr || main->child[1] == nullptr || !main->child[1]->IsTypeOf(StmtType::PARAM_VOID))
+    {
+        return false;
+    }
+    this->whole = true;
+    this->globals = EvalFrame();
+    this->outputs.clear();
+    this->left = std::min(this->steps, this->budget);
+    this->stack = main->symbol_ptr->memloc + 2 + FRAME_EXTRA;
+    EvalFrame frame;
+    bool ok = (this->Exec(main->child[2], frame) != EXEC_FAIL);
+    this->budget -= std::min(this->steps, this->budget) - std::max(this->left, 0LL);
+    this->whole = false;
+    if (!ok)
+    {
+        return false;
+    }
+
+    // 保留变量声明，语句替换为 output(常数) 序列
+    auto body = main->child[2];
+    ASTNodePointer list = nullptr;
+    ASTNodePointer tail = nullptr;
+    for (auto v : this->outputs)
+    {
+        Token t(TokenType::ID, "output");
+        t.row = main->token.row;
+        t.col = main->token.col;
+        ASTNodePointer call = new ASTNode(t, StmtType::FUNC_CALL);
+        call->expType = ExpType::VOID;
+        call->symbol_ptr = this->outputSym;
+        call->AddChild(MakeNum(t, v));
+        ASTNode::Append(list, tail, call);
+    }
+    body->child[1] = list;
+    return true;
+}
+
+void ConstEval::Fold(ASTNodePointer subTree)
+{
+    // 后序遍历，内层调用先被替换
+    for (auto ptr = subTree; ptr != nullptr; ptr = ptr->sibling)
+    {
+        for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+        {
+            this->Fold(ptr->child[i]);
+        }
+        int v = 0;
+        if (ptr->IsTypeOf(StmtType::FUNC_CALL) && this->FoldCall(ptr, v))
+        {
+            ptr->child[0] = nullptr;
+            Token t(TokenType::NUM, std::to_string(v));
+            t.row = ptr->token.row;
+            t.col = ptr->token.col;
+            ptr->token = t;
+            ptr->stmtType = StmtType::NUM;
+            ptr->expType = ExpType::NUM;
+            ptr->symbol_ptr = nullptr;
+            this->folded += 1;
+        }
+    }
+}
+
+bool ConstEval::FoldCall(ASTNodePointer subTree, int &v)
+{
+    auto iter = this->funcs.find(subTree->token.id);
+    if (iter == this->funcs.end() || !iter->second->child[0]->IsTypeOf(StmtType::RET_INT) || this->budget <= 0)
+    {
+        return false;
+    }
+    long long limit = std::min(this->steps, this->budget);
+    this->left = limit;
+    this->stack = 0;
+
+    // 实参必须是常数表达式
+    EvalFrame empty;
+    vector<int> args;
+    bool ok = true;
+    for (auto arg = subTree->child[0]; arg != nullptr && ok; arg = arg->sibling)
+    {
+        int a = 0;
+        ok = this->Eval(arg, empty, a);
+        args.push_back(a);
+    }
+    if (ok)
+    {
+        auto key = std::make_pair(subTree->token.id, args);
+        auto result = this->cache.find(key);
+        if (result == this->cache.end())
+        {
+            vector<EvalArrayPointer> arrs(args.size());
+            int r = 0;
+            bool done = this->Invoke(iter->second, args, arrs, r);
+            result = this->cache.insert({key, {done, r}}).first;
+        }
+        ok = result->second.first;
+        v = result->second.second;
+    }
+    this->budget -= limit - std::max(this->left, 0LL);
+    return ok;
+}
+
+bool ConstEval::Call(ASTNodePointer subTree, EvalFrame &frame, int &v)
+{
+    auto sym = subTree->symbol_ptr;
+    if (sym == nullptr || sym->builtin == SymNode::INPUT)
+    {
+        return false;
+    }
+    if (sym->builtin == SymNode::OUTPUT)
+    {
+        if (!this->whole || !this->Eval(subTree->child[0], frame, v))
+        {
+            return false;
+        }
+        this->outputs.push_back(v);
+        return this->outputs.size() <= MAX_OUTPUT;
+    }
+    if (auto b = BuiltIn::Find(sym))
+    {
+        return this->Native(subTree, *b, frame, v);
+    }
+    auto iter = this->funcs.find(subTree->token.id);
+    if (iter == this->funcs.end())
+    {
+        return false;
+    }
+
+    // 从左到右计算实参，数组按引用传递
+    vector<int> args;
+    vector<EvalArrayPointer> arrs;
+    for (auto arg = subTree->child[0]; arg != nullptr; arg = arg->sibling)
+    {
+        int a = 0;
+        EvalArrayPointer arr = nullptr;
+        if (arg->IsTypeOf(StmtType::VAR_CALL) && arg->symbol_ptr->IsArr())
+        {
+            arr = this->Array(arg->symbol_ptr, frame);
+            if (arr == nullptr)
+            {
+                return false;
+            }
+        }
+        else if (!this->Eval(arg, frame, a))
+        {
+            return false;
+        }
+        args.push_back(a);
+        arrs.push_back(arr);
+    }
+    return this->Invoke(iter->second, args, arrs, v);
+}
+
+bool ConstEval::Native(ASTNodePointer subTree, const BuiltIn &b, EvalFrame &frame, int &v)
+{
+    vector<int> args;
+    vector<EvalArrayPointer> arrs;
+    for (auto arg = subTree->child[0]; arg != nullptr; arg = arg->sibling)
+    {
+        int a = 0;
+        EvalArrayPointer arr = nullptr;
+        if (arg->IsTypeOf(StmtType::VAR_CALL) && arg->symbol_ptr->IsArr())
+        {
+            arr = this->Array(arg->symbol_ptr, frame);
+            if (arr == nullptr)
+            {
+                return false;
+            }
+        }
+        else if (!this->Eval(arg, frame, a))
+        {
+            return false;
+        }
+        args.push_back(a);
+        arrs.push_back(arr);
+    }
+
+    // 区间超出数组时运行时会访问到相邻的内存，放弃求值
+    int n = args.back();
+    int start = b.offset ? args[args.size() - 2] : 0;
+    if (n <= 0)
+    {
+        v = (b.op == "VFIND") ? -1 : 0;
+        return true;
+    }
+    this->left -= n;
+    if (this->left < 0 || start < 0)
+    {
+        return false;
+    }
+    for (auto &arr : arrs)
+    {
+        if (arr != nullptr && static_cast<long long>(start) + n > static_cast<long long>(arr->data.size()))
+        {
+            return false;
+        }
+    }
+    // 第一个数组是写入的目标，其余数组的元素必须都已赋值
+    bool writes = !b.HasResult() && b.op != "VSORT";
+    for (size_t k = writes ? 1 : 0; k < arrs.size(); ++k)
+    {
+        for (int i = 0; arrs[k] != nullptr && i < n; ++i)
+        {
+            if (!arrs[k]->init[start + i])
+            {
+                return false;
+            }
+        }
+    }
+
+    auto &a = arrs[0]->data;
+    auto first = a.begin() + start, last = first + n;
+    if (b.op == "VADD" || b.op == "VSUB" || b.op == "VMUL")
+    {
+        auto &x = arrs[1]->data, &y = arrs[2]->data;
+        for (int i = start; i < start + n; ++i)
+        {
+            long long l = x[i], r = y[i];
+            a[i] = Wrap((b.op == "VADD") ? l + r : (b.op == "VSUB") ? l - r : l * r);
+        }
+    }
+    else if (b.op == "VFILL")
+    {
+        std::fill(first, last, args[1]);
+    }
+    else if (b.op == "VCOPY")
+    {
+        std::copy(arrs[1]->data.begin() + start, arrs[1]->data.begin() + start + n, first);
+    }
+    else if (b.op == "VSORT")
+    {
+        std::sort(first, last);
+    }
+    else if (b.op == "VSUM")
+    {
+        long long s = 0;
+        for (auto ptr = first; ptr != last; ++ptr)
+        {
+            s = Wrap(s + *ptr);
+        }
+        v = static_cast<int>(s);
+    }
+    else if (b.op == "VMIN")
+    {
+        v = *std::min_element(first, last);
+    }
+    else if (b.op == "VMAX")
+    {
+        v = *std::max_element(first, last);
+    }
+    else if (b.op == "VFIND")
+    {
+        auto pos = std::find(first, last, args[1]);
+        v = (pos == last) ? -1 : static_cast<int>(pos - first);
+    }
+    else
+    {
+        return false;
+    }
+    if (writes)
+    {
+        std::fill(arrs[0]->init.begin() + start, arrs[0]->init.begin() + start + n, true);
+    }
+    return true;
+}
+
+bool ConstEval::Invoke(ASTNodePointer func, const vector<int> &args, const vector<EvalArrayPointer> &arrs, int &v)
+{
+    int cost = func->symbol_ptr->memloc + args.size() + 2 + FRAME_EXTRA;
+    if (this->stack + cost > MAX_STACK)
+    {
+        return false;
+    }
+    EvalFrame frame;
+    size_t k = 0;
+    for (auto param = func->child[1]; param != nullptr; param = param->sibling)
+    {
+        if (param->IsTypeOf(StmtType::PARAM_VOID))
+        {
+            continue;
+        }
+        if (k >= args.size())
+        {
+            return false;
+        }
+        if (param->IsTypeOf(StmtType::PARAM_ARR))
+        {
+            if (arrs[k] == nullptr)
+            {
+                return false;
+            }
+            frame.arrs[param->symbol_ptr] = arrs[k];
+        }
+        else
+        {
+            frame.vars[param->symbol_ptr] = args[k];
+        }
+        ++k;
+    }
+    if (k != args.size())
+    {
+        return false;
+    }
+
+    this->stack += cost;
+    this->hasRet = false;
+    int r = this->Exec(func->child[2], frame);
+    this->stack -= cost;
+    if (r == EXEC_FAIL)
+    {
+        return false;
+    }
+    if (func->child[0]->IsTypeOf(StmtType::RET_INT))
+    {
+        // 没有返回值时结果是AC中残留的值
+        if (r != EXEC_RETURN || !this->hasRet)
+        {
+            return false;
+        }
+        v = this->retval;
+    }
+    return true;
+}
+
+int ConstEval::ExecList(ASTNodePointer list, EvalFrame &frame)
+{
+    for (auto ptr = list; ptr != nullptr; ptr = ptr->sibling)
+    {
+        int r = this->Exec(ptr, frame);
+        if (r != EXEC_NEXT)
+        {
+            return r;
+        }
+    }
+    return EXEC_NEXT;
+}
+
+int ConstEval::Exec(ASTNodePointer subTree, EvalFrame &frame)
+{
+    if (subTree == nullptr)
+    {
+        return EXEC_NEXT;
+    }
+    if (!this->Tick())
+    {
+        return EXEC_FAIL;
+    }
+    auto child = subTree->child;
+    int v = 0;
+    switch (subTree->stmtType)
+    {
+    case StmtType::COMP_STMT:
+    {
+        // 进入语句块时，块内声明的变量未初始化
+        for (auto decl = child[0]; decl != nullptr; decl = decl->sibling)
+        {
+            auto sym = decl->symbol_ptr;
+            if (decl->IsTypeOf(StmtType::ARR_DECL))
+            {
+                auto arr = std::make_shared<EvalArray>();
+                arr->data.assign(sym->GetArrSize(), 0);
+                arr->init.assign(sym->GetArrSize(), false);
+                frame.arrs[sym] = arr;
+            }
+            else
+            {
+                frame.vars.erase(sym);
+            }
+        }
+        return this->ExecList(child[1], frame);
+    }
+    case StmtType::IF_STMT:
+    {
+        if (!this->Eval(child[0], frame, v))
+        {
+            return EXEC_FAIL;
+        }
+        return this->ExecList((v != 0) ? child[1] : child[2], frame);
+    }
+    case StmtType::ITER_STMT:
+    {
+        while (true)
+        {
+            if (!this->Eval(child[0], frame, v))
+            {
+                return EXEC_FAIL;
+            }
+            if (v == 0)
+            {
+                return EXEC_NEXT;
+            }
+            int r = this->ExecList(child[1], frame);
+            if (r != EXEC_NEXT)
+            {
+                return r;
+            }
+        }
+    }
+    case StmtType::RET_STMT:
+    {
+        if (child[0] != nullptr && !this->Eval(child[0], frame, v))
+        {
+            return EXEC_FAIL;
+        }
+        this->retval = v;
+        this->hasRet = (child[0] != nullptr);
+        return EXEC_RETURN;
+    }
+    default:
+    {
+        return this->Eval(subTree, frame, v) ? EXEC_NEXT : EXEC_FAIL;
+    }
+    }
+}
+
+bool ConstEval::Eval(ASTNodePointer subTree, EvalFrame &frame, int &v)
+{
+    if (subTree == nullptr || !this->Tick())
+    {
+        return false;
+    }
+    auto child = subTree->child;
+    int l = 0;
+    int r = 0;
+    switch (subTree->stmtType)
+    {
+    case StmtType::NUM:
+    {
+        try
+        {
+            long long x = subTree->token.Value();
+            v = Wrap(x);
+            return v == x;
+        }
+        catch (const std::exception &)
+        {
+            return false;
+        }
+    }
+    case StmtType::VAR_CALL:
+    {
+        auto sym = subTree->symbol_ptr;
+        if (sym->IsArr())
+        {
+            return false;
+        }
+        if (sym->IsGlobal())
+        {
+            // 全局变量的初值为0
+            auto iter = this->globals.vars.find(sym);
+            v = (iter == this->globals.vars.end()) ? 0 : iter->second;
+            return this->whole;
+        }
+        auto iter = frame.vars.find(sym);
+        if (iter == frame.vars.end())
+        {
+            return false;
+        }
+        v = iter->second;
+        return true;
+    }
+    case StmtType::ARR_CALL:
+    {
+        if (!this->Eval(child[0], frame, l))
+        {
+            return false;
+        }
+        auto arr = this->Array(subTree->symbol_ptr, frame);
+        if (arr == nullptr || l < 0 || l >= static_cast<int>(arr->data.size()) || !arr->init[l])
+        {
+            return false;
+        }
+        v = arr->data[l];
+        return true;
+    }
+    case StmtType::ARR_SIZE:
+    {
+        auto arr = this->Array(subTree->symbol_ptr, frame);
+        v = (arr == nullptr) ? 0 : arr->data.size();
+        return arr != nullptr;
+    }
+    case StmtType::FUNC_CALL:
+    {
+        return this->Call(subTree, frame, v);
+    }
+    case StmtType::ADDOP:
+    {
+        if ((child[0] != nullptr && !this->Eval(child[0], frame, l)) || !this->Eval(child[1], frame, r))
+        {
+            return false;
+        }
+        bool plus = subTree->token.IsTypeOf(TokenType::PLUS);
+        v = Wrap(plus ? static_cast<long long>(l) + r : static_cast<long long>(l) - r);
+        return true;
+    }
+    case StmtType::MULOP:
+    {
+        if (!this->Eval(child[0], frame, l) || !this->Eval(child[1], frame, r))
+        {
+            return false;
+        }
+        if (subTree->token.IsTypeOf(TokenType::TIMES))
+        {
+            v = Wrap(static_cast<long long>(l) * r);
+            return true;
+        }
+        if (r == 0 || (l == INT_MIN && r == -1))
+        {
+            // 运行时除零停机
+            return false;
+        }
+        v = l / r;
+        return true;
+    }
+    case StmtType::RELOP:
+    {
+        if (!this->Eval(child[0], frame, l) || !this->Eval(child[1], frame, r))
+        {
+            return false;
+        }
+        // 与虚拟机相同，比较两数之差和0
+        int d = Wrap(static_cast<long long>(l) - r);
+        switch (subTree->token.type)
+        {
+        case TokenType::LT:
+            v = (d < 0);
+            break;
+        case TokenType::LE:
+            v = (d <= 0);
+            break;
+        case TokenType::EQ:
+            v = (d == 0);
+            break;
+        case TokenType::NE:
+            v = (d != 0);
+            break;
+        case TokenType::GE:
+            v = (d >= 0);
+            break;
+        case TokenType::GT:
+            v = (d > 0);
+            break;
+        default:
+            return false;
+        }
+        return true;
+    }
+    case StmtType::ASSIGN_STMT:
+    {
+        // 先计算右值，再计算左值
+        return this->Eval(child[1], frame, v) && this->Assign(child[0], frame, v);
+    }
+    default:
+        break;
+    }
+    return false;
+}
+
+bool ConstEval::Assign(ASTNodePointer left, EvalFrame &frame, int v)
+{
+    if (left == nullptr)
+    {
+        return false;
+    }
+    auto sym = left->symbol_ptr;
+    if (left->IsTypeOf(StmtType::VAR_CALL) && !sym->IsArr())
+    {
+        if (sym->IsGlobal())
+        {
+            this->globals.vars[sym] = v;
+            return this->whole;
+        }
+        frame.vars[sym] = v;
+        return true;
+    }
+    if (left->IsTypeOf(StmtType::ARR_CALL))
+    {
+        int idx = 0;
+        if (!this->Eval(left->child[0], frame, idx))
+        {
+            return false;
+        }
+        auto arr = this->Array(sym, frame);
+        if (arr == nullptr || idx < 0 || idx >= static_cast<int>(arr->data.size()))
+        {
+            return false;
+        }
+        arr->data[idx] = v;
+        arr->init[idx] = true;
+        return true;
+    }
+    return false;
+}
+
+EvalArrayPointer ConstEval::Array(SymNodePointer sym, EvalFrame &frame)
+{
+    if (sym->IsGlobal())
+    {
+        if (!this->whole)
+        {
+            return nullptr;
+        }
+        // 全局数组的初值为0
+        auto &arr = this->globals.arrs[sym];
+        if (arr == nullptr)
+        {
+            arr = std::make_shared<EvalArray>();
+            arr->data.assign(sym->GetArrSize(), 0);
+            arr->init.assign(sym->GetArrSize(), true);
+        }
+        return arr;
+    }
+    auto iter = frame.arrs.find(sym);
+    return (iter == frame.arrs.end()) ? nullptr : iter->second;
+}
+
+bool ConstEval::Tick()
+{
+    this->left -= 1;
+    return this->left >= 0;
+}
+
+int ConstEval::Wrap(long long v)
+{
+    return static_cast<int>(static_cast<uint32_t>(v));
+}
+
+ASTNodePointer ConstEval::MakeNum(const Token &tk, int v)
+{
+    Token t(TokenType::NUM, std::to_string(v));
+    t.row = tk.row;
+    t.col = tk.col;
+    ASTNodePointer node = new ASTNode(t, StmtType::NUM);
+    node->expType = ExpType::NUM;
+    return node;
+}
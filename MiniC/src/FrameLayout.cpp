@@ -0,0 +1,71 @@
+#include "FrameLayout.h"
+#include <algorithm>
+
+int FrameLayout::Run(SymTable &table)
+{
+    this->saved = 0;
+    this->header = table.arrayHeader;
+    auto global = table.symtab;
+    for (auto ptr = global->scope; ptr != nullptr && ptr != global; ptr = ptr->next)
+    {
+        if (!ptr->IsFunc() || !ptr->HasScope())
+        {
+            continue;
+        }
+        int top = this->header ? this->Arrays(ptr, 0) : 0;
+        top = this->Place(ptr, top, !this->header);
+        this->saved += ptr->memloc - top;
+        ptr->memloc = top;
+    }
+    return this->saved;
+}
+
+int FrameLayout::Arrays(SymNodePointer scope, int top)
+{
+    for (auto ptr = scope->scope; ptr != nullptr && ptr != scope; ptr = ptr->next)
+    {
+        if (ptr->IsArr() && ptr->memloc >= 0 && !ptr->IsParam())
+        {
+            // 长度保存在数组首元素之前
+            ptr->memloc = top + 1;
+            top += ptr->GetArrSize() + 1;
+        }
+        else if (ptr->IsBlock() && ptr->HasScope())
+        {
+            top = this->Arrays(ptr, top);
+        }
+    }
+    return top;
+}
+
+int FrameLayout::Place(SymNodePointer scope, int top, bool arr)
+{
+    // 先放置本作用域的变量，参数的位置为负，保持不变
+    for (auto ptr = scope->scope; ptr != nullptr && ptr != scope; ptr = ptr->next)
+    {
+        if (ptr->memloc < 0 || ptr->IsParam())
+        {
+            continue;
+        }
+        if (ptr->IsVar())
+        {
+            ptr->memloc = top++;
+        }
+        else if (ptr->IsArr() && arr)
+        {
+            ptr->memloc = top;
+            top += ptr->GetArrSize();
+        }
+    }
+
+    // 并列的语句块不会同时活跃，从同一位置开始
+    int max = top;
+    for (auto ptr = scope->scope; ptr != nullptr && ptr != scope; ptr = ptr->next)
+    {
+        if (ptr->IsBlock() && ptr->HasScope())
+        {
+            max = std::max(max, this->Place(ptr, top, arr));
+        }
+    }
+    return max;
+}
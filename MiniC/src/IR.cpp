@@ -1,4 +1,7 @@
 #include "IR.h"
+#include "MIR.h"
+#include <algorithm>
+#include <climits>
 
 void IR::PrintIR()
 {
@@ -61,28 +64,51 @@ string IR::ToString()
 }
 
 void IR::GenIR(AST &ast, SymTable &table)
+{
+    if (this->licm)
+    {
+        loops.Run(ast);
+    }
+    int saveloc = GenStart(table);
+
+    this->Gen(ast.root);
+
+    // 调用main
+    int target = inst_offset.at("main");
+    // qps[saveloc].addr2 = to_string(target - saveloc - 1);
+    qps[saveloc].addr2 = to_string(target);
+}
+
+void IR::GenIR(MIR &mir, SymTable &table)
+{
+    int saveloc = GenStart(table);
+    mir.Lower(*this);
+    qps[saveloc].addr2 = to_string(inst_offset.at("main"));
+}
+
+int IR::GenStart(SymTable &table)
 {
     // 初始化
     fp = table.symtab->memloc + 2;
     // EmitRM("LDC", GP, "0", "0", "Init GP");
     EmitRM("LDC", FP, to_string(fp), "0", "Init FP");
+    if (this->boundsCheck == BOUNDS_FULL)
+    {
+        GenArrHeader(table.symtab, GP);
+    }
     // EmitRO("ADD", FP, FP, GP);
 
     int halt = EmitRM("LDC", AC, "?", "0", "Addr To Halt");
+    qps[halt].ctrl = Quadruple::CTRL_ADDR;
     EmitRM("ST", AC, "-2", FP); // 保存出口地址
     EmitRM("ST", FP, "-1", FP); // 占位
 
     int saveloc = EmitRM("LDC", PC, "?", PC, "Call main"); // 当前的pc在saveloc+1
-
-    this->Gen(ast.root);
-
-    // 调用main
-    int target = inst_offset.at("main");
-    // qps[saveloc].addr2 = to_string(target - saveloc - 1);
-    qps[saveloc].addr2 = to_string(target);
-    target = EmitRO("HALT", "0", "0", "0", "Program End");
+    // 出口紧跟在main调用之后，保证启动代码是一个独立的整体
+    int target = EmitRO("HALT", "0", "0", "0", "Program End");
     // 回填出口
     qps[halt].addr2 = to_string(target);
+    return saveloc;
 }
 
 void IR::Gen(ASTNodePointer subTree, bool isAddr)
@@ -100,6 +126,14 @@ void IR::GenStmt(ASTNodePointer subTree, bool isAddr)
         return;
     }
 
+    auto hoist = this->hoisted.find(subTree);
+    if (hoist != this->hoisted.end())
+    {
+        // 循环不变量已在前置块中计算
+        EmitRM("LD", AC, to_string(hoist->second), FP, "Loop Invariant");
+        return;
+    }
+
     switch (subTree->stmtType)
     {
     case StmtType::FUNC_DECL:
@@ -142,7 +176,7 @@ void IR::GenStmt(ASTNodePointer subTree, bool isAddr)
     }
     case StmtType::NUM:
     {
-        EmitRM("LDC", AC, subTree->token.val, "0");
+        EmitRM("LDC", AC, string(subTree->token.Text()), "0");
         break;
     }
     case StmtType::VAR_CALL:
@@ -164,6 +198,26 @@ void IR::GenStmt(ASTNodePointer subTree, bool isAddr)
         GenFC(subTree);
         break;
     }
+    case StmtType::ARR_SIZE:
+    {
+        auto sptr = subTree->symbol_ptr;
+        auto cache = this->arrReg.find(sptr);
+        if (cache != this->arrReg.end())
+        {
+            EmitRM("LD", AC, "-1", cache->second, "Load Arr Size");
+        }
+        else if (sptr->IsParam())
+        {
+            // 长度保存在数组首元素之前
+            EmitRM("LD", BP, to_string(sptr->memloc), FP);
+            EmitRM("LD", AC, "-1", BP, "Load Arr Size");
+        }
+        else
+        {
+            EmitRM("LDC", AC, to_string(sptr->GetArrSize()), "0", "Load Arr Size");
+        }
+        break;
+    }
     default:
         break;
     }
@@ -178,13 +232,19 @@ void IR::GenFunc(ASTNodePointer subTree)
     }
     // 处理参数和变量的空间
     auto child = subTree->child;
-    this->inst_offset[subTree->token.val] = qps.size(); // 记录入口位置
+    string name(subTree->token.Text());
+    this->inst_offset[name] = qps.size(); // 记录入口位置
     // 预分配空间
     int tmp = fp;
     fp = subTree->symbol_ptr->memloc;
+    this->frameTop = fp;
+    this->curFunc = subTree->symbol_ptr;
     int saveloc = qps.size();
+    if (this->boundsCheck == BOUNDS_FULL)
+    {
+        GenArrHeader(subTree->symbol_ptr, FP);
+    }
     Gen(child[2]);
-    EmitComment(" <- Ent " + subTree->token.val, saveloc);
 
     // 如果函数末尾没有return语句，加上
     ASTNodePointer ptr = child[2];
@@ -196,19 +256,25 @@ void IR::GenFunc(ASTNodePointer subTree)
     {
         GenRet(nullptr);
     }
+    this->frameSize[name] = std::max(this->frameTop, subTree->symbol_ptr->memloc);
+    EmitComment(" <- Ent " + name + " Frame " + to_string(this->frameSize[name]), saveloc);
+    this->inst_end[name] = qps.size(); // 记录结束位置
     fp = tmp;
 }
 
 void IR::GenRet(ASTNodePointer subTree)
 {
+    if (subTree && GenTailCall(subTree->child[0]))
+    {
+        return;
+    }
     if (subTree && subTree->child[0])
     {
         // 有返回值
         Gen(subTree->child[0], false);
         EmitComment("Return Value");
     }
-    EmitRM("LDC", BP, "0", "0", "Ret: Clear BP");
-    EmitRO("ADD", BP, BP, FP, "Ret: Save Current FP To BP");
+    EmitRM("LDA", BP, "0", FP, "Ret: Save Current FP To BP");
 
     EmitRM("LD", FP, "-1", BP, "Restore FP");
     EmitRM("LD", PC, "-2", BP, "Ret");
@@ -256,6 +322,16 @@ void IR::GenIter(ASTNodePointer subTree)
     }
     auto child = subTree->child;
 
+    // 循环不变量外提到前置块，循环结束后释放占用的栈空间和寄存器
+    int top = fp;
+    vector<ASTNodePointer> exps;
+    vector<SymNodePointer> arrs;
+    auto loop = this->licm ? loops.Find(subTree) : nullptr;
+    if (loop != nullptr)
+    {
+        GenPreheader(*loop, exps, arrs);
+    }
+
     // condition
     int saveLoc, curLoc, fail;
     saveLoc = qps.size();
@@ -270,6 +346,91 @@ void IR::GenIter(ASTNodePointer subTree)
     curLoc = qps.size();
     qps[fail].addr2 = to_string(curLoc - fail - 1);
     qps[jmp].addr2 = to_string(saveLoc - curLoc);
+
+    for (auto exp : exps)
+    {
+        this->hoisted.erase(exp);
+    }
+    for (auto arr : arrs)
+    {
+        this->arrReg.erase(arr);
+    }
+    fp = top;
+}
+
+void IR::GenPreheader(const LoopInfo &loop, vector<ASTNodePointer> &exps, vector<SymNodePointer> &arrs)
+{
+    int begin = qps.size();
+
+    // 结构相同的不变表达式共用一个位置
+    map<string, int> slots;
+    for (auto exp : loop.invariants)
+    {
+        if (this->hoisted.count(exp))
+        {
+            // 已经被外层循环外提
+            continue;
+        }
+        string key = LoopAnalysis::Key(exp);
+        auto iter = slots.find(key);
+        if (iter == slots.end())
+        {
+            Gen(exp, false);
+            iter = slots.insert({key, fp++}).first;
+            EmitRM("ST", AC, to_string(iter->second), FP);
+        }
+        this->hoisted[exp] = iter->second;
+        exps.push_back(exp);
+    }
+
+    // 循环内没有函数调用时，使用次数最多的数组基址放入空闲寄存器
+    if (!loop.hasCall)
+    {
+        vector<std::pair<int, SymNodePointer>> uses;
+        for (auto &a : loop.arrays)
+        {
+            if (!this->arrReg.count(a.first))
+            {
+                uses.push_back({a.second, a.first});
+            }
+        }
+        std::stable_sort(uses.begin(), uses.end(), [](const auto &a, const auto &b)
+                         { return a.first > b.first || (a.first == b.first && a.second->memloc < b.second->memloc); });
+        auto use = uses.begin();
+        for (auto &reg : {AR1, AR2})
+        {
+            bool busy = false;
+            for (auto &r : this->arrReg)
+            {
+                busy = busy || (r.second == reg);
+            }
+            if (busy || use == uses.end())
+            {
+                continue;
+            }
+            auto sptr = use->second;
+            if (sptr->IsGlobal())
+            {
+                EmitRM("LDA", reg, to_string(sptr->memloc), GP);
+            }
+            else if (sptr->IsParam())
+            {
+                EmitRM("LD", reg, to_string(sptr->memloc), FP);
+            }
+            else
+            {
+                EmitRM("LDA", reg, to_string(sptr->memloc), FP);
+            }
+            this->arrReg[sptr] = reg;
+            arrs.push_back(sptr);
+            ++use;
+        }
+    }
+
+    if (begin != static_cast<int>(qps.size()))
+    {
+        EmitComment("Loop Preheader", begin);
+    }
 }
 
 void IR::GenExp(ASTNodePointer subTree, bool isAddr)
@@ -284,6 +445,10 @@ void IR::GenExp(ASTNodePointer subTree, bool isAddr)
     ASTNodePointer right = subTree->child[1];
     string op;
 
+    if (this->GenConstOp(subTree))
+    {
+        return;
+    }
     switch (subTree->stmtType)
     {
     case StmtType::ADDOP:
@@ -400,27 +565,146 @@ void IR::GenFC(ASTNodePointer subTree)
     }
     auto child = subTree->child;
     SymNodePointer sptr = nullptr;
-    string reg;
     // 内置函数
     sptr = subTree->symbol_ptr;
-    if (sptr->tag == "F:G:input:I:V")
+    if (sptr->builtin == SymNode::INPUT)
     {
         EmitRO("IN", AC, "0", "0"); //从标准输入流读入一个整型数据到AC
         return;
     }
-    else if (sptr->tag == "F:G:output:V:I")
+    else if (sptr->builtin == SymNode::OUTPUT)
     {
         GenStmt(child[0]);
         EmitRO("OUT", AC, "0", "0"); //输出一个整型数据到标准输出流
         return;
     }
+    else if (auto b = BuiltIn::Find(sptr))
+    {
+        GenBuiltIn(subTree, *b);
+        return;
+    }
     // 记录栈顶fp
     int top = fp;
-    // 从左到右计算实参
-    int begin_args = qps.size();
-    for (auto arg = child[0]; arg != nullptr; arg = arg->sibling)
+    GenArgs(child[0]);
+    if (GenInline(subTree))
+    {
+        fp = top;
+        return;
+    }
+
+    // int loc = EmitRM("LDC", AC, "?", "0", "Call: Load Return Addr"); // 返回地址
+    int ret = EmitRM("LDC", AC, to_string(qps.size() + 5), "0", "Call: Load Return Addr"); // 返回地址
+    qps[ret].ctrl = Quadruple::CTRL_ADDR;
+    EmitRM("ST", AC, to_string(fp++), FP, "Call: Save Ret");                     // 保存返回地址PC  -2
+    EmitRM("ST", FP, to_string(fp++), FP, "Call: Save FP");                      // 保存Old FP     -1
+    EmitRM("LDA", FP, to_string(fp), FP, "Call:Modify FP");
+    // CALL
+    string name(subTree->token.Text());
+    EmitRM("LDC", PC, to_string(this->inst_offset[name]), "0", "Call: Jump To" + name);
+    // qps[loc].addr2 = to_string(qps.size());
+
+    // 函数调用结束 清理栈内存
+    fp = top;
+}
+
+bool IR::GenConstOp(ASTNodePointer subTree)
+{
+    // 常数直接作为立即数或装入AC1，不需要在栈上保存另一个操作数
+    // 乘以2的幂改为左移，非负数除以2的幂改为算术右移
+    if (!subTree->IsTypeOf(StmtType::ADDOP) && !subTree->IsTypeOf(StmtType::MULOP))
+    {
+        return false;
+    }
+    ASTNodePointer x = subTree->child[0];
+    ASTNodePointer k = subTree->child[1];
+    if (k == nullptr)
     {
+        // 负号开头的操作数不是单独的子结点
+        return false;
+    }
+    bool swap =subTree->token.IsTypeOf(TokenType::PLUS) || subTree->token.IsTypeOf(TokenType::TIMES);
+    if (swap && x != nullptr && x->IsTypeOf(StmtType::NUM) && !k->IsTypeOf(StmtType::NUM))
+    {
+        std::swap(x, k);
+    }
+    if (x == nullptr || !k->IsTypeOf(StmtType::NUM))
+    {
+        return false;
+    }
+    long long c = 0;
+    try
+    {
+        c = k->token.Value();
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    if (c > INT_MAX || (subTree->token.IsTypeOf(TokenType::DIVISION) && c == 0))
+    {
+        // 除以0留给虚拟机报错
+        return false;
+    }
+
+    int shift = 0;
+    while (shift < 31 && (1LL << shift) < c)
+    {
+        ++shift;
+    }
+    bool pow2 = (c == (1LL << shift));
+    Gen(x, false);
+    switch (subTree->token.type)
+    {
+    case TokenType::PLUS:
+    case TokenType::MINUS:
+    {
+        if (c != 0)
+        {
+            EmitRM("LDA", AC, to_string(subTree->token.IsTypeOf(TokenType::PLUS) ? c : -c), AC);
+        }
+        break;
+    }
+    case TokenType::TIMES:
+    {
+        if (c == 0)
+        {
+            EmitRM("LDC", AC, "0", "0");
+        }
+        else if (pow2 && shift > 0)
+        {
+            EmitRM("SHL", AC, to_string(shift), AC, "Mul By Power Of 2");
+        }
+        else if (c != 1)
+        {
+            EmitRM("LDC", AC1, to_string(c), "0");
+            EmitRO("MUL", AC, AC, AC1);
+        }
+        break;
+    }
+    default:
+    {
+        if (pow2 && shift > 0 && subTree->HasAttr(ASTNode::ATTR_NONNEG))
+        {
+            EmitRM("SHR", AC, to_string(shift), AC, "Div By Power Of 2");
+        }
+        else if (c != 1)
+        {
+            EmitRM("LDC", AC1, to_string(c), "0");
+            EmitRO("DIV", AC, AC, AC1);
+        }
+        break;
+    }
+    }
+    return true;
+}
 
+void IR::GenArgs(ASTNodePointer args)
+{
+    int begin_args = qps.size();
+    for (auto arg = args; arg != nullptr; arg = arg->sibling)
+    {
+        SymNodePointer sptr = nullptr;
+        string reg;
         switch (arg->stmtType)
         {
         case StmtType::NUM:
@@ -466,24 +750,267 @@ void IR::GenFC(ASTNodePointer subTree)
             break;
         }
     }
-    if (child[0])
+    if (args)
     {
         EmitComment("Begin Args", begin_args);
     }
+}
 
-    // int loc = EmitRM("LDC", AC, "?", "0", "Call: Load Return Addr"); // 返回地址
-    EmitRM("LDC", AC, to_string(qps.size() + 5), "0", "Call: Load Return Addr"); // 返回地址
-    EmitRM("ST", AC, to_string(fp++), FP, "Call: Save Ret");                     // 保存返回地址PC  -2
-    EmitRM("ST", FP, to_string(fp++), FP, "Call: Save FP");                      // 保存Old FP     -1
-    EmitRM("LDA", FP, to_string(fp), FP, "Call:Modify FP");
-    // CALL
-    EmitRM("LDC", PC, to_string(this->inst_offset[subTree->token.val]), "0", "Call: Jump To" + subTree->token.val);
-    // qps[loc].addr2 = to_string(qps.size());
+void IR::GenBuiltIn(ASTNodePointer subTree, const BuiltIn &b)
+{
+    // 实参先全部算出存放在栈上，再装入寄存器：元素个数放在AC，其余依次放在 AC1/BP/AR1
+    int top = fp;
+    GenArgs(subTree->child[0]);
+    int n = fp - top;
+    int k = n - (b.offset ? 2 : 1);
+    const string regs[] = {AC1, BP, AR1};
+    int begin = qps.size();
 
-    // 函数调用结束 清理栈内存
+    // AR1 可能缓存着外层循环的数组基址
+    int saved = -1;
+    for (auto &r : this->arrReg)
+    {
+        if (r.second == AR1 && k > 2)
+        {
+            saved = fp++;
+            EmitRM("ST", AR1, to_string(saved), FP, "Save Cached Arr Addr");
+            break;
+        }
+    }
+    auto &ptype = subTree->symbol_ptr->GetPType();
+    if (this->boundsCheck == BOUNDS_FULL && !b.offset)
+    {
+        // 元素个数不能超过数组头部记录的长度
+        EmitRM("LD", AC, to_string(top + n - 1), FP, "Load Element Count");
+        for (int i = 0; i < k; ++i)
+        {
+            if (ptype[i] == SymType::ARR)
+            {
+                EmitRM("LD", AC1, to_string(top + i), FP);
+                EmitRM("LD", AC1, "-1", AC1, "Load Arr Size");
+                EmitRO("SUB", AC1, AC1, AC);
+                EmitRM("JGE", AC1, "1", PC, "Check Element Count");
+                EmitRO("HALT", "-2", "0", "0", "Shutdown If Count Is Out Of Range");
+            }
+        }
+    }
+    for (int i = 0; i < k; ++i)
+    {
+        EmitRM("LD", regs[i], to_string(top + i), FP);
+    }
+    auto start = subTree->child[0];
+    for (int i = 0; b.offset && i < n - 2; ++i)
+    {
+        start = start->sibling;
+    }
+    if (b.offset && !(start->IsTypeOf(StmtType::NUM) && start->token.Text() == "0"))
+    {
+        // 起始下标加到每个数组的基址上
+        EmitRM("LD", AC, to_string(top + n - 2), FP, "Load Start Offset");
+        for (int i = 0; i < k; ++i)
+        {
+            if (ptype[i] == SymType::ARR)
+            {
+                EmitRO("ADD", regs[i], regs[i], AC);
+            }
+        }
+    }
+    EmitRM("LD", AC, to_string(top + n - 1), FP, "Load Element Count");
+
+    // 有返回值时结果写回AC
+    vector<string> operands;
+    if (b.HasResult())
+    {
+        operands.push_back(AC);
+    }
+    operands.insert(operands.end(), regs, regs + k);
+    operands.resize(3, "0");
+    EmitRO(b.op, operands[0], operands[1], operands[2]);
+    if (saved >= 0)
+    {
+        EmitRM("LD", AR1, to_string(saved), FP, "Restore Cached Arr Addr");
+    }
+    EmitComment("Builtin " + b.name, begin);
     fp = top;
 }
 
+bool IR::GenTailCall(ASTNodePointer subTree)
+{
+    if (!this->tailCall || subTree == nullptr || !subTree->IsTypeOf(StmtType::FUNC_CALL))
+    {
+        return false;
+    }
+    auto sptr = subTree->symbol_ptr;
+    string name(subTree->token.Text());
+    auto entry = this->inst_offset.find(name);
+    if (entry == this->inst_offset.end() || sptr->builtin == SymNode::INPUT || sptr->builtin == SymNode::OUTPUT)
+    {
+        return false;
+    }
+    // 被调函数的参数必须放得进当前函数的参数区
+    int m = ParamCount(sptr);
+    if (m > ParamCount(this->curFunc))
+    {
+        return false;
+    }
+    for (auto arg = subTree->child[0]; arg != nullptr; arg = arg->sibling)
+    {
+        auto a = arg->symbol_ptr;
+        if (arg->IsTypeOf(StmtType::VAR_CALL) && a->IsArr() && !a->IsGlobal() && !a->IsParam())
+        {
+            // 局部数组会被被调函数的栈帧覆盖
+            return false;
+        }
+    }
+
+    // 实参先全部算出，再覆盖参数区，实参可能用到当前的参数
+    int top = fp;
+    GenArgs(subTree->child[0]);
+    int begin = qps.size();
+    for (int k = 0; k < m; ++k)
+    {
+        EmitRM("LD", AC, to_string(top + k), FP);
+        EmitRM("ST", AC, to_string(-2 - m + k), FP);
+    }
+    if (begin != static_cast<int>(qps.size()))
+    {
+        EmitComment("Tail Call: Overwrite Params", begin);
+    }
+    int jmp = EmitRM("LDC", PC, to_string(entry->second), "0", "Tail Call: Jump To " + name);
+    qps[jmp].ctrl = Quadruple::CTRL_TAIL;
+    fp = top;
+    return true;
+}
+
+bool IR::GenInline(ASTNodePointer subTree)
+{
+    // 实参已经按调用约定存放在 fp 开始的位置，被调函数的栈帧整体平移到调用者栈帧的 fp+2 处
+    string name(subTree->token.Text());
+    auto iter = this->inst_end.find(name);
+    if (iter == this->inst_end.end())
+    {
+        // 函数尚未生成完毕(递归调用自身)
+        return false;
+    }
+    int entry = this->inst_offset.at(name);
+    int end = iter->second;
+
+    // 代价模型：返回序列会被一条跳转代替，调用序列和返回序列被省去
+    int size = 0;
+    bool leaf = true;
+    for (int i = entry; i < end; ++i)
+    {
+        auto &q = qps[i];
+        if (q.ctrl == Quadruple::CTRL_TAIL)
+        {
+            // 尾调用依赖真实的栈帧
+            return false;
+        }
+        if (q.ctrl == Quadruple::CTRL_CALL)
+        {
+            leaf = false;
+            if (std::stoi(q.addr2) == entry)
+            {
+                // 递归函数不内联
+                return false;
+            }
+        }
+        size += (q.ctrl == Quadruple::CTRL_RET) ? -(RET_SIZE - 1) : 1;
+    }
+    if (size > (leaf ? this->inlineLeaf : this->inlineSize))
+    {
+        return false;
+    }
+
+    // 计算每条指令复制后的位置，返回序列的前几条指令被省去
+    int delta = fp + 2;
+    vector<int> pos(end - entry + 1);
+    int n = qps.size();
+    for (int i = entry; i < end; ++i)
+    {
+        pos[i - entry] = n;
+        bool skip = false;
+        for (int k = 1; k < RET_SIZE && i + k < end; ++k)
+        {
+            skip = skip || (qps[i + k].ctrl == Quadruple::CTRL_RET);
+        }
+        n += skip ? 0 : 1;
+    }
+    pos[end - entry] = n;
+
+    vector<int> exits;
+    int begin = qps.size();
+    for (int i = entry; i < end; ++i)
+    {
+        if (pos[i - entry] == pos[i + 1 - entry])
+        {
+            continue;
+        }
+        Quadruple q = qps[i];
+        switch (q.ctrl)
+        {
+        case Quadruple::CTRL_RET:
+        {
+            exits.push_back(EmitRM("LDA", PC, "?", PC, "Inline: Return"));
+            continue;
+        }
+        case Quadruple::CTRL_JUMP:
+        {
+            int t = i + 1 + std::stoi(q.addr2);
+            q.addr2 = to_string(pos[t - entry] - pos[i - entry] - 1);
+            break;
+        }
+        case Quadruple::CTRL_ADDR:
+        {
+            q.addr2 = to_string(pos[std::stoi(q.addr2) - entry]);
+            break;
+        }
+        default:
+            break;
+        }
+        if (q.opt == Quadruple::TYPE_RM && q.addr3 == FP)
+        {
+            // 被调函数栈帧中的位置映射到调用者栈帧
+            q.addr2 = to_string(std::stoi(q.addr2) + delta);
+        }
+        if (i == entry)
+        {
+            q.comment.clear();
+        }
+        qps.push_back(q);
+    }
+    EmitComment("Inline " + name, begin);
+    this->frameTop = std::max(this->frameTop, delta + this->frameSize[name]);
+
+    // 回填返回跳转，末尾的跳转直接删除
+    if (!exits.empty() && exits.back() == static_cast<int>(qps.size()) - 1)
+    {
+        exits.pop_back();
+        qps.pop_back();
+    }
+    for (auto loc : exits)
+    {
+        qps[loc].addr2 = to_string(qps.size() - loc - 1);
+    }
+    return true;
+}
+
+void IR::GenArrHeader(SymNodePointer scope, const string &reg)
+{
+    for (auto ptr = scope->scope; ptr != nullptr && ptr != scope; ptr = ptr->next)
+    {
+        if (ptr->IsArr() && !ptr->IsParam())
+        {
+            EmitRM("LDC", AC, to_string(ptr->GetArrSize()), "0", "Init Arr Size");
+            EmitRM("ST", AC, to_string(ptr->memloc - 1), reg);
+        }
+        else if (ptr->IsBlock() && ptr->HasScope())
+        {
+            GenArrHeader(ptr, reg);
+        }
+    }
+}
+
 void IR::GenAC(ASTNodePointer subTree, bool isAddr)
 {
     if (subTree == nullptr)
@@ -493,11 +1020,21 @@ void IR::GenAC(ASTNodePointer subTree, bool isAddr)
     auto child = subTree->child;
     Gen(child[0], false); // 计算下标值,保存在AC
     // 负下标检查
-    EmitRM("JGE", AC, "1", PC, "Check Negative Array Offset");
-    EmitRO("HALT", "-1", "0", "0", "Shutdown If Offset Is Negative");
+    if (this->boundsCheck != BOUNDS_NONE && !subTree->HasAttr(ASTNode::ATTR_LOW_SAFE))
+    {
+        EmitRM("JGE", AC, "1", PC, "Check Negative Array Offset");
+        EmitRO("HALT", "-1", "0", "0", "Shutdown If Offset Is Negative");
+    }
 
     auto sptr = subTree->symbol_ptr;
-    if (sptr->IsGlobal())
+    string base = BP;
+    auto cache = this->arrReg.find(sptr);
+    if (cache != this->arrReg.end())
+    {
+        // 基址已缓存在寄存器中
+        base = cache->second;
+    }
+    else if (sptr->IsGlobal())
     {
         EmitRM("LDA", BP, to_string(sptr->memloc), GP);
     }
@@ -511,7 +1048,23 @@ void IR::GenAC(ASTNodePointer subTree, bool isAddr)
         EmitRM("LDA", BP, to_string(sptr->memloc), FP);
     }
 
-    EmitRO("ADD", BP, AC, BP); // 计算偏移地址
+    // 上界检查
+    if (this->boundsCheck == BOUNDS_FULL && !subTree->HasAttr(ASTNode::ATTR_HIGH_SAFE))
+    {
+        if (sptr->IsParam())
+        {
+            EmitRM("LD", AC1, "-1", base, "Load Arr Size");
+            EmitRO("SUB", AC1, AC, AC1);
+        }
+        else
+        {
+            EmitRM("LDA", AC1, to_string(-sptr->GetArrSize()), AC);
+        }
+        EmitRM("JLT", AC1, "1", PC, "Check Array Offset Upper Bound");
+        EmitRO("HALT", "-2", "0", "0", "Shutdown If Offset Is Out Of Range");
+    }
+
+    EmitRO("ADD", BP, AC, base); // 计算偏移地址
     if (!isAddr)
     {
         EmitRM("LD", AC, "0", BP); // 将值读入到AC
@@ -521,29 +1074,64 @@ void IR::GenAC(ASTNodePointer subTree, bool isAddr)
 int IR::EmitRO(string op, string r, string s, string t)
 {
     qps.push_back({op, r, s, t, Quadruple::TYPE_RO});
+    qps.back().ctrl = CtrlType(op, r, "");
     return qps.size() - 1;
 }
 
 int IR::EmitRM(string op, string r, string d, string s)
 {
+    if (s == FP && r != FP && d != "?")
+    {
+        // 记录栈帧中用到的最高位置，调用时修改FP的指令属于被调函数的栈帧
+        this->frameTop = std::max(this->frameTop, std::stoi(d) + 1);
+    }
     qps.push_back({op, r, d, s, Quadruple::TYPE_RM});
+    qps.back().ctrl = CtrlType(op, r, s);
     return qps.size() - 1;
 }
 
 int IR::EmitRO(string op, string r, string s, string t, string c)
 {
-    qps.push_back({op, r, s, t, Quadruple::TYPE_RO});
+    EmitRO(op, r, s, t);
     EmitComment(c);
     return qps.size() - 1;
 }
 
 int IR::EmitRM(string op, string r, string d, string s, string c)
 {
-    qps.push_back({op, r, d, s, Quadruple::TYPE_RM});
+    EmitRM(op, r, d, s);
     EmitComment(c);
     return qps.size() - 1;
 }
 
+int IR::CtrlType(const string &op, const string &r, const string &s)
+{
+    if (op == "HALT")
+    {
+        return Quadruple::CTRL_HALT;
+    }
+    if (s == PC && op != "LD" && op != "ST" && op != "LDC")
+    {
+        // J** r,d(PC) 和 LDA PC,d(PC)
+        return Quadruple::CTRL_JUMP;
+    }
+    if (r == PC && op == "LDC")
+    {
+        return Quadruple::CTRL_CALL;
+    }
+    if (r == PC && op == "LD")
+    {
+        return Quadruple::CTRL_RET;
+    }
+    return Quadruple::CTRL_NONE;
+}
+
+int IR::ParamCount(SymNodePointer func)
+{
+    auto &ptype = func->GetPType();
+    return (ptype.size() == 1 && ptype[0] == SymType::VOID) ? 0 : ptype.size();
+}
+
 void IR::EmitComment(string c, int ind)
 {
     if (ind < 0)
@@ -0,0 +1,359 @@
+#include "JumpThread.h"
+
+int JumpThread::Run(CFG &cfg, IR &ir)
+{
+    this->cfg = &cfg;
+    this->ir = &ir;
+    this->threaded = 0;
+    this->removed = 0;
+    int size = ir.qps.size();
+    if (cfg.blocks.empty())
+    {
+        return 0;
+    }
+
+    // 代码中存在跳转构成的死循环时改写可能不会停止，限制轮数
+    bool changed = true;
+    for (int round = 0; changed && round < MAX_CHAIN; ++round)
+    {
+        this->refs.assign(size + 1, 0);
+        for (auto &f : cfg.funcs)
+        {
+            ++this->refs[f.entry];
+        }
+        for (int i = 0; i < size; ++i)
+        {
+            if (!cfg.removed[i] && cfg.target[i] >= 0)
+            {
+                ++this->refs[this->Next(cfg.target[i])];
+            }
+        }
+
+        changed = false;
+        for (int i = 0; i < size; ++i)
+        {
+            if (!cfg.removed[i] && ir.qps[i].ctrl == Quadruple::CTRL_JUMP)
+            {
+                changed = this->Rewrite(i) || changed;
+            }
+        }
+    }
+
+    if (this->threaded + this->removed > 0)
+    {
+        cfg.Linearize();
+    }
+    return this->threaded + this->removed;
+}
+
+bool JumpThread::Rewrite(int i)
+{
+    auto &qps = this->ir->qps;
+    auto &target = this->cfg->target;
+    int size = qps.size();
+    auto &q = qps[i];
+    bool cond = this->IsCondJump(i);
+    int v = 0;
+
+    // 条件在编译期确定：总是跳转时改为无条件跳转，从不跳转时删除
+    if (cond && this->Known(i, q.addr1, v))
+    {
+        if (Taken(q.iop, v))
+        {
+            q.iop = "LDA";
+            q.addr1 = IR::PC;
+            ++this->threaded;
+        }
+        else
+        {
+            this->Remove(i);
+        }
+        return true;
+    }
+
+    // 跳转到下一条指令
+    int t = this->Next(target[i]);
+    if (t == this->Next(i + 1))
+    {
+        this->Remove(i);
+        return true;
+    }
+
+    // 沿无条件跳转链
+    int f = this->Final(t);
+    if (f != t)
+    {
+        this->Retarget(i, f);
+        return true;
+    }
+
+    // 目标为 LDC r,c; J** r,d(PC)，r 在结果位置不再被读取时越过这两条指令
+    if (t >= size)
+    {
+        return false;
+    }
+    auto &qt = qps[t];
+    if (qt.opt == Quadruple::TYPE_RM && qt.iop == "LDC" && qt.ctrl == Quadruple::CTRL_NONE)
+    {
+        int t2 = this->Next(t + 1);
+        if (t2 < size && this->IsCondJump(t2) && qps[t2].addr1 == qt.addr1)
+        {
+            int nt = Taken(qps[t2].iop, std::stoi(qt.addr2)) ? this->Next(target[t2]) : this->Next(t2 + 1);
+            int budget = MAX_CHAIN;
+            if (nt != t && this->Dead(nt, qt.addr1, budget))
+            {
+                this->Retarget(i, nt);
+                return true;
+            }
+        }
+    }
+
+    // LDC r,c; LDA PC,d(PC) 跳转到 J** r,d(PC)，直接跳转到结果位置
+    if (!cond && this->IsCondJump(t) && this->Known(i, qps[t].addr1, v))
+    {
+        int nt = Taken(qps[t].iop, v) ? this->Next(target[t]) : this->Next(t + 1);
+        if (nt != t)
+        {
+            int k = this->Prev(i);
+            string r = qps[t].addr1;
+            this->Retarget(i, nt);
+            int budget = MAX_CHAIN;
+            if (this->Dead(nt, r, budget))
+            {
+                this->Remove(k);
+            }
+            return true;
+        }
+    }
+
+    // 无条件跳转之后没有被引用的指令不可达，删除后条件跳转才能与跳转相邻
+    bool changed = false;
+    for (int p = this->Next(i + 1); !cond && p < t && this->refs[p] == 0; p = this->Next(p + 1))
+    {
+        this->Remove(p);
+        changed = true;
+    }
+    if (changed)
+    {
+        return true;
+    }
+
+    // J** r,2(PC); LDA PC,d(PC) 反转为 J!** r,d+1(PC)
+    if (cond)
+    {
+        int j = this->Next(i + 1);
+        if (j < size && this->IsJump(j) && this->refs[j] == 0 && t == this->Next(j + 1) &&
+            this->cfg->FuncOf(j) == this->cfg->FuncOf(i))
+        {
+            q.iop = Inverse(q.iop);
+            this->Retarget(i, this->Next(target[j]));
+            this->Remove(j);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JumpThread::Retarget(int i, int t)
+{
+    auto &target = this->cfg->target;
+    --this->refs[this->Next(target[i])];
+    target[i] = t;
+    ++this->refs[t];
+    ++this->threaded;
+}
+
+void JumpThread::Remove(int i)
+{
+    auto &target = this->cfg->target;
+    if (target[i] >= 0)
+    {
+        --this->refs[this->Next(target[i])];
+    }
+    this->cfg->removed[i] = true;
+    ++this->removed;
+
+    // 指向被删除指令的引用落到下一条保留的指令
+    int next = this->Next(i + 1);
+    this->refs[next] += this->refs[i];
+    this->refs[i] = 0;
+}
+
+int JumpThread::Next(int i) const
+{
+    int size = this->ir->qps.size();
+    while (i < size && this->cfg->removed[i])
+    {
+        ++i;
+    }
+    return i;
+}
+
+int JumpThread::Prev(int i) const
+{
+    // i 没有被引用时只能从前一条保留的指令顺序执行到达
+    if (this->refs[i] > 0)
+    {
+        return -1;
+    }
+    int k = i - 1;
+    while (k >= 0 && this->cfg->removed[k])
+    {
+        --k;
+    }
+    if (k < 0 || this->ir->qps[k].ctrl != Quadruple::CTRL_NONE || this->cfg->FuncOf(k) != this->cfg->FuncOf(i))
+    {
+        return -1;
+    }
+    return k;
+}
+
+int JumpThread::Final(int t) const
+{
+    int size = this->ir->qps.size();
+    int p = this->Next(t);
+    for (int n = 0; n < MAX_CHAIN; ++n)
+    {
+        if (p >= size || !this->IsJump(p))
+        {
+            return p;
+        }
+        p = this->Next(this->cfg->target[p]);
+    }
+    // 跳转链构成循环
+    return this->Next(t);
+}
+
+bool JumpThread::Known(int i, const string &r, int &v) const
+{
+    int k = this->Prev(i);
+    if (k < 0)
+    {
+        return false;
+    }
+    auto &q = this->ir->qps[k];
+    if (q.opt != Quadruple::TYPE_RM || q.iop != "LDC" || q.ctrl != Quadruple::CTRL_NONE || q.addr1 != r)
+    {
+        return false;
+    }
+    v = std::stoi(q.addr2);
+    return true;
+}
+
+bool JumpThread::Dead(int t, const string &r, int &budget) const
+{
+    auto &qps = this->ir->qps;
+    int size = qps.size();
+    int p = this->Next(t);
+    while (p < size && budget-- > 0)
+    {
+        auto &q = qps[p];
+        if (q.ctrl == Quadruple::CTRL_HALT)
+        {
+            return true;
+        }
+        if (q.ctrl == Quadruple::CTRL_CALL || q.ctrl == Quadruple::CTRL_TAIL || q.ctrl == Quadruple::CTRL_RET)
+        {
+            return false;
+        }
+        if (q.ctrl == Quadruple::CTRL_JUMP)
+        {
+            if (this->IsJump(p))
+            {
+                p = this->Next(this->cfg->target[p]);
+                continue;
+            }
+            return q.addr1 != r && this->Dead(this->cfg->target[p], r, budget) && this->Dead(p + 1, r, budget);
+        }
+
+        // IN/OUT 和 LDC 没有用到的操作数也是"0"，不能看作读取 AC
+        bool reads = false, writes = false;
+        if (q.opt == Quadruple::TYPE_RO && BuiltIn::FindOp(q.iop) != nullptr)
+        {
+            // 向量指令读取AC中的元素个数和全部操作数
+            reads = (r == IR::AC || q.addr1 == r || q.addr2 == r || q.addr3 == r);
+        }
+        else if (q.opt == Quadruple::TYPE_RO)
+        {
+            reads = (q.iop == "OUT") ? (q.addr1 == r) : (q.iop != "IN" && (q.addr2 == r || q.addr3 == r));
+            writes = (q.iop != "OUT" && q.addr1 == r);
+        }
+        else
+        {
+            reads = (q.iop != "LDC" && q.addr3 == r) || (q.iop == "ST" && q.addr1 == r);
+            writes = (q.iop != "ST" && q.addr1 == r);
+        }
+        if (reads)
+        {
+            return false;
+        }
+        if (writes)
+        {
+            return true;
+        }
+        p = this->Next(p + 1);
+    }
+    return false;
+}
+
+bool JumpThread::IsJump(int i) const
+{
+    auto &q = this->ir->qps[i];
+    return q.ctrl == Quadruple::CTRL_JUMP && q.iop == "LDA";
+}
+
+bool JumpThread::IsCondJump(int i) const
+{
+    auto &q = this->ir->qps[i];
+    return q.ctrl == Quadruple::CTRL_JUMP && !q.iop.empty() && q.iop[0] == 'J';
+}
+
+bool JumpThread::Taken(const string &op, int v)
+{
+    if (op == "JEQ")
+    {
+        return v == 0;
+    }
+    if (op == "JNE")
+    {
+        return v != 0;
+    }
+    if (op == "JLT")
+    {
+        return v < 0;
+    }
+    if (op == "JLE")
+    {
+        return v <= 0;
+    }
+    if (op == "JGT")
+    {
+        return v > 0;
+    }
+    return v >= 0; // JGE
+}
+
+string JumpThread::Inverse(const string &op)
+{
+    if (op == "JEQ")
+    {
+        return "JNE";
+    }
+    if (op == "JNE")
+    {
+        return "JEQ";
+    }
+    if (op == "JLT")
+    {
+        return "JGE";
+    }
+    if (op == "JGE")
+    {
+        return "JLT";
+    }
+    if (op == "JLE")
+    {
+        return "JGT";
+    }
+    return "JLE"; // JGT
+}
@@ -0,0 +1,454 @@
+#include "Liveness.h"
+#include <algorithm>
+#include <climits>
+
+int Liveness::Run(CFG &cfg, IR &ir, SymTable &table)
+{
+    this->cfg = &cfg;
+    this->ir = &ir;
+    this->removed = 0;
+    auto global = table.symtab;
+    for (auto &f : cfg.funcs)
+    {
+        if (!f.reachable)
+        {
+            continue;
+        }
+        for (auto ptr = global->scope; ptr != nullptr && ptr != global; ptr = ptr->next)
+        {
+            if (ptr->IsFunc() && ptr->token_ptr != nullptr && ptr->token_ptr->Text() == f.name)
+            {
+                this->removed += this->RunFunc(f, ptr);
+                break;
+            }
+        }
+    }
+    return this->removed;
+}
+
+void Liveness::Collect(SymNodePointer scope, set<int> &scalars, set<int> &arrays)
+{
+    for (auto ptr = scope->scope; ptr != nullptr && ptr != scope; ptr = ptr->next)
+    {
+        if (ptr->IsVar() || (ptr->IsArr() && ptr->IsParam()))
+        {
+            // 数组参数只占一个位置，保存数组的地址
+            scalars.insert(ptr->memloc);
+        }
+        else if (ptr->IsArr())
+        {
+            // 长度头和全部元素
+            int size = ptr->GetArrSize();
+            for (int i = ptr->memloc - 1; i < ptr->memloc + size; ++i)
+            {
+                arrays.insert(i);
+            }
+        }
+        else if (ptr->IsBlock() && ptr->HasScope())
+        {
+            Collect(ptr, scalars, arrays);
+        }
+    }
+}
+
+vector<Liveness::Effect> Liveness::Effects(CFGFunc &f, SymNodePointer sym, int &nloc)
+{
+    auto &qps = ir->qps;
+    int frame = sym->memloc;
+    const int FP = std::stoi(IR::FP);
+    set<int> scalars, arrays;
+    Collect(sym, scalars, arrays);
+
+    // 临时位置的地址被取出时(内联展开的数组和变量)，临时位置不参与分析
+    bool temps = true;
+    for (int i = f.entry; i < f.end; ++i)
+    {
+        auto &q = qps[i];
+        if (q.opt == Quadruple::TYPE_RM && q.iop == "LDA" && q.addr3 == IR::FP && q.addr1 != IR::FP &&
+            std::stoi(q.addr2) >= std::max(frame, 1))
+        {
+            temps = false;
+        }
+    }
+
+    // 基本块内跟踪 FP+常数 形式的地址，得到每条访存指令访问的栈帧位置
+    vector<int> offset(f.end - f.entry, INT_MIN);
+    map<int, int> slots;
+    map<int, map<int, int>> exitKnown; // 基本块结束时保存栈帧地址的寄存器
+    set<int> escaped;                  // 地址参与了运算的位置
+    auto track = [&](int o)
+    {
+        return scalars.count(o) || (temps && o >= frame && !arrays.count(o));
+    };
+    for (auto b : f.blocks)
+    {
+        auto &bb = cfg->blocks[b];
+        if (!bb.reachable)
+        {
+            continue;
+        }
+        map<int, int> known{{FP, 0}};
+        for (int i = bb.begin; i < bb.end; ++i)
+        {
+            auto &q = qps[i];
+            if (q.opt != Quadruple::TYPE_RM)
+            {
+                // 向量指令的第一个操作数也可能是地址
+                bool vec = BuiltIn::FindOp(q.iop) != nullptr;
+                for (auto a : {&q.addr1, &q.addr2, &q.addr3})
+                {
+                    if (a == &q.addr1 && !vec)
+                    {
+                        continue;
+                    }
+                    auto k = known.find(std::stoi(*a));
+                    if (k != known.end() && k->first != FP)
+                    {
+                        escaped.insert(k->second);
+                    }
+                }
+                known.erase(std::stoi(q.addr1));
+                continue;
+            }
+            int r = std::stoi(q.addr1), d = std::stoi(q.addr2), s = std::stoi(q.addr3);
+            auto base = known.find(s);
+            if ((q.iop == "LD" || q.iop == "ST") && base != known.end())
+            {
+                int o = base->second + d;
+                offset[i - f.entry] = o;
+                if (track(o) && !slots.count(o))
+                {
+                    int id = NREG + slots.size();
+                    slots[o] = id;
+                }
+            }
+            if (q.iop == "ST")
+            {
+                auto k = known.find(r);
+                if (k != known.end() && r != FP)
+                {
+                    escaped.insert(k->second);
+                }
+                continue;
+            }
+            if (q.iop == "LDA" && base != known.end() && r != FP)
+            {
+                known[r] = base->second + d;
+            }
+            else
+            {
+                known.erase(r);
+            }
+        }
+        known.erase(FP);
+        exitKnown[b] = known;
+    }
+    nloc = NREG + slots.size();
+
+    vector<Effect> effects(f.end - f.entry);
+    auto reg = [](const string &r, vector<int> &set)
+    {
+        int x = std::stoi(r);
+        if (x >= 0 && x < NREG)
+        {
+            set.push_back(x);
+        }
+    };
+    for (int i = f.entry; i < f.end; ++i)
+    {
+        auto &q = qps[i];
+        auto &e = effects[i - f.entry];
+        int r = std::stoi(q.addr1);
+        if (r >= NREG && r < 8)
+        {
+            // 修改 GP/FP/PC
+            e.side = true;
+        }
+        if (q.opt == Quadruple::TYPE_RO)
+        {
+            if (q.iop == "HALT")
+            {
+                e.side = true;
+                continue;
+            }
+            if (q.iop == "IN")
+            {
+                reg(q.addr1, e.def);
+                e.side = true;
+                continue;
+            }
+            if (q.iop == "OUT")
+            {
+                reg(q.addr1, e.use);
+                e.side = true;
+                continue;
+            }
+            if (auto b = BuiltIn::FindOp(q.iop))
+            {
+                // 向量指令读取AC中的元素个数和各操作数，读写数组，结果写回AC
+                reg(IR::AC, e.use);
+                reg(q.addr1, e.use);
+                reg(q.addr2, e.use);
+                reg(q.addr3, e.use);
+                if (b->HasResult())
+                {
+                    reg(IR::AC, e.def);
+                }
+                e.side = true;
+                continue;
+            }
+            // 除数为0时停机
+            e.side = e.side || (q.iop == "DIV");
+            reg(q.addr1, e.def);
+            reg(q.addr2, e.use);
+            reg(q.addr3, e.use);
+            continue;
+        }
+
+        switch (q.ctrl)
+        {
+        case Quadruple::CTRL_CALL:
+        {
+            // 被调函数读取存放在临时位置的实参，返回值在AC中
+            for (auto &s : slots)
+            {
+                if (s.first >= frame)
+                {
+                    e.use.push_back(s.second);
+                }
+            }
+            e.def.push_back(std::stoi(IR::AC));
+            e.side = true;
+            continue;
+        }
+        case Quadruple::CTRL_TAIL:
+        {
+            // 被调函数复用当前栈帧
+            for (auto &s : slots)
+            {
+                e.use.push_back(s.second);
+            }
+            e.side = true;
+            continue;
+        }
+        case Quadruple::CTRL_RET:
+        {
+            reg(IR::AC, e.use);
+            reg(q.addr3, e.use);
+            e.side = true;
+            continue;
+        }
+        case Quadruple::CTRL_JUMP:
+        {
+            if (q.iop[0] == 'J')
+            {
+                reg(q.addr1, e.use);
+            }
+            e.side = true;
+            continue;
+        }
+        default:
+            break;
+        }
+
+        if (q.iop != "LDC")
+        {
+            reg(q.addr3, e.use);
+        }
+        int o = offset[i - f.entry];
+        auto slot = (o == INT_MIN) ? slots.end() : slots.find(o);
+        if (q.iop == "ST")
+        {
+            reg(q.addr1, e.use);
+            if (slot != slots.end())
+            {
+                e.def.push_back(slot->second);
+            }
+            else
+            {
+                // 数组、全局变量或未分析的位置
+                e.side = true;
+            }
+            continue;
+        }
+        if (q.iop == "LD" && slot != slots.end())
+        {
+            e.use.push_back(slot->second);
+        }
+        reg(q.addr1, e.def);
+    }
+
+    // 基本块结束时仍保存着栈帧地址的寄存器如果在后继块中被读取，该地址同样逃逸
+    for (auto &exit : exitKnown)
+    {
+        for (auto &k : exit.second)
+        {
+            if (track(k.second) && !escaped.count(k.second) && this->Reads(f, effects, exit.first, k.first))
+            {
+                escaped.insert(k.second);
+            }
+        }
+    }
+
+    // 基址未知的读取可能访问地址逃逸的位置
+    vector<int> maybe;
+    for (auto o : escaped)
+    {
+        auto slot = slots.find(o);
+        if (slot != slots.end())
+        {
+            maybe.push_back(slot->second);
+        }
+    }
+    for (int i = f.entry; i < f.end && !maybe.empty(); ++i)
+    {
+        auto &q = qps[i];
+        bool vec = q.opt == Quadruple::TYPE_RO && BuiltIn::FindOp(q.iop) != nullptr;
+        if ((vec || (q.opt == Quadruple::TYPE_RM && (q.iop == "LD" || q.ctrl == Quadruple::CTRL_CALL))) &&
+            offset[i - f.entry] == INT_MIN)
+        {
+            auto &use = effects[i - f.entry].use;
+            use.insert(use.end(), maybe.begin(), maybe.end());
+        }
+    }
+    return effects;
+}
+
+bool Liveness::Reads(CFGFunc &f, const vector<Effect> &effects, int block, int r)
+{
+    // 从 block 的后继开始沿控制流查找在重新定值之前读取 r 的指令
+    set<int> visited;
+    vector<int> work(cfg->blocks[block].succ);
+    while (!work.empty())
+    {
+        int b = work.back();
+        work.pop_back();
+        if (!visited.insert(b).second)
+        {
+            continue;
+        }
+        auto &bb = cfg->blocks[b];
+        bool killed = false;
+        for (int i = bb.begin; i < bb.end && !killed; ++i)
+        {
+            auto &e = effects[i - f.entry];
+            if (std::find(e.use.begin(), e.use.end(), r) != e.use.end())
+            {
+                return true;
+            }
+            killed = std::find(e.def.begin(), e.def.end(), r) != e.def.end();
+        }
+        if (!killed)
+        {
+            work.insert(work.end(), bb.succ.begin(), bb.succ.end());
+        }
+    }
+    return false;
+}
+
+int Liveness::RunFunc(CFGFunc &f, SymNodePointer sym)
+{
+    int nloc = 0;
+    auto effects = this->Effects(f, sym, nloc);
+    auto &blocks = cfg->blocks;
+    auto &dead = cfg->removed;
+
+    // 逆序经过一条指令：live = (live - def) ∪ use
+    auto transfer = [&](int i, vector<bool> &live)
+    {
+        auto &e = effects[i - f.entry];
+        for (auto d : e.def)
+        {
+            live[d] = false;
+        }
+        for (auto u : e.use)
+        {
+            live[u] = true;
+        }
+    };
+
+    int count = 0;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        map<int, vector<bool>> liveIn;
+        for (auto b : f.blocks)
+        {
+            liveIn[b].assign(nloc, false);
+        }
+        bool iter = true;
+        while (iter)
+        {
+            iter = false;
+            for (auto it = f.blocks.rbegin(); it != f.blocks.rend(); ++it)
+            {
+                auto &bb = blocks[*it];
+                if (!bb.reachable)
+                {
+                    continue;
+                }
+                vector<bool> live(nloc, false);
+                for (auto s : bb.succ)
+                {
+                    for (int k = 0; k < nloc; ++k)
+                    {
+                        live[k] = live[k] || liveIn[s][k];
+                    }
+                }
+                for (int i = bb.end - 1; i >= bb.begin; --i)
+                {
+                    if (!dead[i])
+                    {
+                        transfer(i, live);
+                    }
+                }
+                if (live != liveIn[bb.id])
+                {
+                    liveIn[bb.id] = live;
+                    iter = true;
+                }
+            }
+        }
+
+        // 删除结果不再使用的指令
+        for (auto b : f.blocks)
+        {
+            auto &bb = blocks[b];
+            if (!bb.reachable)
+            {
+                continue;
+            }
+            vector<bool> live(nloc, false);
+            for (auto s : bb.succ)
+            {
+                for (int k = 0; k < nloc; ++k)
+                {
+                    live[k] = live[k] || liveIn[s][k];
+                }
+            }
+            for (int i = bb.end - 1; i >= bb.begin; --i)
+            {
+                if (dead[i])
+                {
+                    continue;
+                }
+                auto &e = effects[i - f.entry];
+                bool used = e.side || e.def.empty();
+                for (auto d : e.def)
+                {
+                    used = used || live[d];
+                }
+                if (!used)
+                {
+                    dead[i] = true;
+                    changed = true;
+                    ++count;
+                    continue;
+                }
+                transfer(i, live);
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,182 @@
+#include "Loop.h"
+#include <cstdint>
+
+void LoopAnalysis::Run(AST &ast)
+{
+    loops.clear();
+    loopOf.clear();
+    for (auto ptr = ast.root; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (ptr->IsTypeOf(StmtType::FUNC_DECL))
+        {
+            this->Visit(ptr->child[2], -1);
+        }
+    }
+    // 所有循环的写集合确定之后再寻找不变表达式
+    for (auto &loop : loops)
+    {
+        this->Collect(loop.node->child[0], loop);
+        this->Collect(loop.node->child[1], loop);
+    }
+}
+
+const LoopInfo *LoopAnalysis::Find(ASTNodePointer node) const
+{
+    auto iter = loopOf.find(node);
+    return (iter == loopOf.end()) ? nullptr : &loops[iter->second];
+}
+
+void LoopAnalysis::Visit(ASTNodePointer subTree, int loop)
+{
+    for (auto ptr = subTree; ptr != nullptr; ptr = ptr->sibling)
+    {
+        int cur = loop;
+        switch (ptr->stmtType)
+        {
+        case StmtType::ITER_STMT:
+        {
+            LoopInfo info;
+            info.node = ptr;
+            info.parent = loop;
+            info.depth = (loop < 0) ? 1 : loops[loop].depth + 1;
+            cur = loops.size();
+            loopOf[ptr] = cur;
+            loops.push_back(info);
+            break;
+        }
+        case StmtType::ASSIGN_STMT:
+        {
+            auto left = ptr->child[0];
+            if (loop >= 0 && left != nullptr && left->IsTypeOf(StmtType::VAR_CALL))
+            {
+                loops[loop].writes.insert(left->symbol_ptr);
+            }
+            break;
+        }
+        case StmtType::FUNC_CALL:
+        {
+            if (loop >= 0 && !IsBuiltin(ptr->symbol_ptr))
+            {
+                loops[loop].hasCall = true;
+            }
+            break;
+        }
+        case StmtType::ARR_CALL:
+        case StmtType::ARR_SIZE:
+        {
+            if (loop >= 0)
+            {
+                loops[loop].arrays[ptr->symbol_ptr] += 1;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+        {
+            this->Visit(ptr->child[i], cur);
+        }
+
+        if (cur != loop && loop >= 0)
+        {
+            // 内层循环的信息并入外层循环
+            auto &inner = loops[cur];
+            auto &outer = loops[loop];
+            outer.writes.insert(inner.writes.begin(), inner.writes.end());
+            outer.hasCall = outer.hasCall || inner.hasCall;
+            for (auto &a : inner.arrays)
+            {
+                outer.arrays[a.first] += a.second;
+            }
+        }
+    }
+}
+
+void LoopAnalysis::Collect(ASTNodePointer subTree, LoopInfo &loop)
+{
+    for (auto ptr = subTree; ptr != nullptr; ptr = ptr->sibling)
+    {
+        switch (ptr->stmtType)
+        {
+        case StmtType::ADDOP:
+        case StmtType::MULOP:
+        case StmtType::RELOP:
+        {
+            // 只外提最大的不变子表达式
+            if (this->IsInvariant(ptr, loop))
+            {
+                loop.invariants.push_back(ptr);
+                continue;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+        {
+            this->Collect(ptr->child[i], loop);
+        }
+    }
+}
+
+bool LoopAnalysis::IsInvariant(ASTNodePointer exp, const LoopInfo &loop) const
+{
+    if (exp == nullptr)
+    {
+        return true;
+    }
+    switch (exp->stmtType)
+    {
+    case StmtType::NUM:
+        return true;
+    case StmtType::VAR_CALL:
+    {
+        // 函数调用可能修改全局变量，局部变量和参数只能在本函数内修改
+        auto sym = exp->symbol_ptr;
+        return sym->IsVar() && loop.writes.count(sym) == 0 && !(sym->IsGlobal() && loop.hasCall);
+    }
+    case StmtType::MULOP:
+    {
+        auto right = exp->child[1];
+        if (exp->token.IsTypeOf(TokenType::DIVISION) &&
+            !(right != nullptr && right->IsTypeOf(StmtType::NUM) && right->token.Text().find_first_not_of('0') != string::npos))
+        {
+            // 外提后即使循环不执行也会计算，除数必须是非零常数
+            return false;
+        }
+        return this->IsInvariant(exp->child[0], loop) && this->IsInvariant(right, loop);
+    }
+    case StmtType::ADDOP:
+    case StmtType::RELOP:
+        return this->IsInvariant(exp->child[0], loop) && this->IsInvariant(exp->child[1], loop);
+    default:
+        break;
+    }
+    return false;
+}
+
+string LoopAnalysis::Key(ASTNodePointer exp)
+{
+    if (exp == nullptr)
+    {
+        return "_";
+    }
+    switch (exp->stmtType)
+    {
+    case StmtType::NUM:
+        return string(exp->token.Text());
+    case StmtType::VAR_CALL:
+        return "$" + std::to_string(reinterpret_cast<uintptr_t>(exp->symbol_ptr));
+    default:
+        break;
+    }
+    return "(" + string(exp->token.Text()) + " " + Key(exp->child[0]) + " " + Key(exp->child[1]) + ")";
+}
+
+bool LoopAnalysis::IsBuiltin(SymNodePointer sym)
+{
+    return sym != nullptr && sym->builtin != SymNode::USER;
+}
@@ -0,0 +1,335 @@
+#include "LoopUnroll.h"
+#include "Loop.h"
+#include <climits>
+#include <cstdint>
+
+void LoopUnroll::Run(AST &ast)
+{
+    this->unrolled = 0;
+    this->flattened = 0;
+    for (auto ptr = ast.root; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (ptr->IsTypeOf(StmtType::FUNC_DECL))
+        {
+            this->Visit(ptr->child[2]);
+        }
+    }
+}
+
+void LoopUnroll::Visit(ASTNodePointer list)
+{
+    ASTNodePointer prev = nullptr;
+    for (auto ptr = list; ptr != nullptr; prev = ptr, ptr = ptr->sibling)
+    {
+        // 先处理内层，含有循环的循环体不再展开
+        for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+        {
+            this->Visit(ptr->child[i]);
+        }
+        if (ptr->IsTypeOf(StmtType::ITER_STMT))
+        {
+            this->Unroll(ptr, prev);
+        }
+    }
+}
+
+bool LoopUnroll::Unroll(ASTNodePointer loop, ASTNodePointer prev)
+{
+    auto cond = loop->child[0];
+    auto body = loop->child[1];
+    // 含有函数调用的循环体展开后调用处还会被内联，而循环本身的开销相对很小
+    if (cond == nullptr || body == nullptr || !cond->IsTypeOf(StmtType::RELOP) || this->HasLoop(body) ||
+        this->HasCall(body))
+    {
+        return false;
+    }
+
+    // 条件为 x < e 或 x <= e，e > x 和 e >= x 交换两边
+    auto x = cond->child[0];
+    auto e = cond->child[1];
+    TokenType op = cond->token.type;
+    if (op == TokenType::GT || op == TokenType::GE)
+    {
+        std::swap(x, e);
+        op = (op == TokenType::GT) ? TokenType::LT : TokenType::LE;
+    }
+    if (op != TokenType::LT && op != TokenType::LE)
+    {
+        return false;
+    }
+    if (x == nullptr || e == nullptr || !x->IsTypeOf(StmtType::VAR_CALL) || x->symbol_ptr == nullptr ||
+        !x->symbol_ptr->IsVar() || x->symbol_ptr->IsGlobal())
+    {
+        return false;
+    }
+    SymNodePointer xs = x->symbol_ptr;
+    bool eNum = e->IsTypeOf(StmtType::NUM);
+    if (!eNum)
+    {
+        auto es = e->symbol_ptr;
+        if (!e->IsTypeOf(StmtType::VAR_CALL) || es == nullptr || !es->IsVar() || es == xs ||
+            this->CountAssign(body, es) > 0)
+        {
+            return false;
+        }
+    }
+
+    // 循环体顶层恰好有一条 x = x + c (c > 0) 修改x
+    ASTNodePointer list = body->IsTypeOf(StmtType::COMP_STMT) ? body->child[1] : body;
+    long long c = 0;
+    for (auto ptr = list; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (!ptr->IsTypeOf(StmtType::ASSIGN_STMT) || ptr->child[0] == nullptr ||
+            !ptr->child[0]->IsTypeOf(StmtType::VAR_CALL) || ptr->child[0]->symbol_ptr != xs)
+        {
+            continue;
+        }
+        auto rhs = ptr->child[1];
+        if (rhs == nullptr || !rhs->IsTypeOf(StmtType::ADDOP) || !rhs->token.IsTypeOf(TokenType::PLUS) ||
+            rhs->child[0] == nullptr || rhs->child[1] == nullptr)
+        {
+            continue;
+        }
+        for (int side = 0; side < 2; ++side)
+        {
+            auto v = rhs->child[side];
+            auto n = rhs->child[1 - side];
+            if (v->IsTypeOf(StmtType::VAR_CALL) && v->symbol_ptr == xs && n->IsTypeOf(StmtType::NUM))
+            {
+                c = n->token.Value();
+            }
+        }
+    }
+    if (c <= 0 || c > INT_MAX / MAX_FACTOR || this->CountAssign(body, xs) != 1)
+    {
+        return false;
+    }
+
+    // 循环前的语句为 x = 常数时初值已知
+    bool xNum = prev != nullptr && prev->IsTypeOf(StmtType::ASSIGN_STMT) && prev->child[0] != nullptr &&
+                prev->child[0]->IsTypeOf(StmtType::VAR_CALL) && prev->child[0]->symbol_ptr == xs &&
+                prev->child[1] != nullptr && prev->child[1]->IsTypeOf(StmtType::NUM);
+    long long x0 = xNum ? prev->child[1]->token.Value() : 0;
+    long long ev = eNum ? e->token.Value() : 0;
+    int size = this->CountNodes(body);
+
+    // 迭代次数已知且很少时完全展开
+    if (xNum && eNum)
+    {
+        long long trips = 0;
+        for (long long v = x0; trips <= FULL_TRIPS && Compare(op, v, ev); ++trips)
+        {
+            v = static_cast<int32_t>(static_cast<uint32_t>(v) + static_cast<uint32_t>(c));
+        }
+        if (trips <= FULL_TRIPS && trips * size <= FULL_SIZE)
+        {
+            auto copies = this->Copies(body, trips);
+            loop->stmtType = StmtType::COMP_STMT;
+            loop->child[0] = nullptr;
+            loop->child[1] = copies->child[1];
+            ++this->flattened;
+            return true;
+        }
+    }
+
+    if (this->factor < 2 || this->factor > MAX_FACTOR || size > MAX_BODY)
+    {
+        return false;
+    }
+    long long k = (this->factor - 1) * c;
+
+    // 进入时原条件成立，x-e 回绕后为负，此后主循环的条件成立则k份循环体的原条件都成立
+    // x 的初值和 e 都是常数时在编译期判断，否则在主循环前检查一次原条件
+    if (eNum && ev - k < INT_MIN)
+    {
+        return false;
+    }
+    bool guard = true;
+    if (xNum && eNum)
+    {
+        if (!Compare(op, x0, ev))
+        {
+            return false;
+        }
+        guard = false;
+    }
+    ASTNodePointer bound = eNum ? this->MakeNum(e->token, ev - k)
+                                : this->MakeOp(loop->token, StmtType::ADDOP, TokenType::MINUS, e->Clone(), this->MakeNum(loop->token, k));
+    ASTNodePointer fast = new ASTNode(loop->token, StmtType::ITER_STMT);
+    fast->AddChild(this->MakeOp(cond->token, StmtType::RELOP, op, x->Clone(), bound));
+    fast->AddChild(this->Copies(body, this->factor));
+
+    ASTNodePointer head = fast;
+    if (guard)
+    {
+        head = new ASTNode(loop->token, StmtType::IF_STMT);
+        head->AddChild(cond->Clone());
+        head->AddChild(fast);
+    }
+
+    // while 结点原地改写为 { 主循环; 原循环 }，原循环作为余数循环
+    // 循环可能是 if/while 的唯一子语句，不能在后面插入兄弟结点
+    ASTNodePointer rest = new ASTNode(loop->token, StmtType::ITER_STMT);
+    rest->AddChild(cond);
+    rest->AddChild(body);
+    head->sibling = rest;
+    loop->stmtType = StmtType::COMP_STMT;
+    loop->child[0] = nullptr;
+    loop->child[1] = head;
+    ++this->unrolled;
+    return true;
+}
+
+ASTNodePointer LoopUnroll::Copies(ASTNodePointer body, long long n)
+{
+    ASTNodePointer comp = new ASTNode(body->token, StmtType::COMP_STMT);
+    ASTNodePointer tail = nullptr;
+    for (long long i = 0; i < n; ++i)
+    {
+        ASTNodePointer copy = body->Clone();
+        if (tail == nullptr)
+        {
+            comp->child[1] = copy;
+        }
+        else
+        {
+            tail->sibling = copy;
+        }
+        tail = copy;
+    }
+    return comp;
+}
+
+int LoopUnroll::CountAssign(ASTNodePointer subTree, SymNodePointer sym)
+{
+    if (subTree == nullptr)
+    {
+        return 0;
+    }
+    int count = 0;
+    if (subTree->IsTypeOf(StmtType::ASSIGN_STMT) && subTree->child[0] != nullptr &&
+        subTree->child[0]->symbol_ptr == sym)
+    {
+        count += 1;
+    }
+    for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+    {
+        for (auto ptr = subTree->child[i]; ptr != nullptr; ptr = ptr->sibling)
+        {
+            count += this->CountAssign(ptr, sym);
+        }
+    }
+    return count;
+}
+
+bool LoopUnroll::HasCall(ASTNodePointer subTree)
+{
+    if (subTree == nullptr)
+    {
+        return false;
+    }
+    if (subTree->IsTypeOf(StmtType::FUNC_CALL) && !LoopAnalysis::IsBuiltin(subTree->symbol_ptr))
+    {
+        return true;
+    }
+    for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+    {
+        for (auto ptr = subTree->child[i]; ptr != nullptr; ptr = ptr->sibling)
+        {
+            if (this->HasCall(ptr))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool LoopUnroll::HasLoop(ASTNodePointer subTree)
+{
+    if (subTree == nullptr)
+    {
+        return false;
+    }
+    if (subTree->IsTypeOf(StmtType::ITER_STMT))
+    {
+        return true;
+    }
+    for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+    {
+        for (auto ptr = subTree->child[i]; ptr != nullptr; ptr = ptr->sibling)
+        {
+            if (this->HasLoop(ptr))
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int LoopUnroll::CountNodes(ASTNodePointer subTree)
+{
+    if (subTree == nullptr)
+    {
+        return 0;
+    }
+    int n = 1;
+    for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+    {
+        for (auto ptr = subTree->child[i]; ptr != nullptr; ptr = ptr->sibling)
+        {
+            n += this->CountNodes(ptr);
+        }
+    }
+    return n;
+}
+
+ASTNodePointer LoopUnroll::MakeNum(const Token &tk, long long v)
+{
+    Token t(TokenType::NUM, std::to_string(v));
+    t.row = tk.row;
+    t.col = tk.col;
+    ASTNodePointer node = new ASTNode(t, StmtType::NUM);
+    node->expType = ExpType::NUM;
+    return node;
+}
+
+ASTNodePointer LoopUnroll::MakeOp(const Token &tk, StmtType st, TokenType op, ASTNodePointer l, ASTNodePointer r)
+{
+    string val;
+    switch (op)
+    {
+    case TokenType::LT:
+        val = "<";
+        break;
+    case TokenType::LE:
+        val = "<=";
+        break;
+    case TokenType::GT:
+        val = ">";
+        break;
+    case TokenType::MINUS:
+        val = "-";
+        break;
+    case TokenType::TIMES:
+        val = "*";
+        break;
+    default:
+        break;
+    }
+    Token t(op, val);
+    t.row = tk.row;
+    t.col = tk.col;
+    ASTNodePointer node = new ASTNode(t, st);
+    node->expType = ExpType::INT;
+    node->AddChild(l);
+    node->AddChild(r);
+    return node;
+}
+
+bool LoopUnroll::Compare(TokenType op, long long x, long long e)
+{
+    int32_t d = static_cast<int32_t>(static_cast<uint32_t>(x) - static_cast<uint32_t>(e));
+    return (op == TokenType::LT) ? (d < 0) : (d <= 0);
+}
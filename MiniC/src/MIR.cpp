@@ -0,0 +1,2471 @@
+#include "MIR.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <set>
+#include <tuple>
+
+bool MInst::IsPure() const
+{
+    switch (op)
+    {
+    case CONST:
+    case ADD:
+    case SUB:
+    case MUL:
+    case CMP:
+    case SHL:
+    case SHR:
+    case GLOAD:
+    case ADDR:
+    case SIZE:
+    case PHI:
+        return true;
+    default:
+        break;
+    }
+    return false;
+}
+
+int MFunc::NewValue(bool mem)
+{
+    isMem.push_back(mem);
+    alias.push_back(-1);
+    return nvalue++;
+}
+
+int MFunc::Find(int v)
+{
+    while (v >= 0 && alias[v] >= 0)
+    {
+        v = alias[v];
+    }
+    return v;
+}
+
+void MFunc::Replace(int from, int to)
+{
+    from = this->Find(from);
+    to = this->Find(to);
+    if (from != to)
+    {
+        alias[from] = to;
+    }
+}
+
+void MIR::Build(AST &ast)
+{
+    funcs.clear();
+    for (auto ptr = ast.root; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (ptr->IsTypeOf(StmtType::FUNC_DECL))
+        {
+            this->BuildFunc(ptr);
+        }
+    }
+    this->func = nullptr;
+}
+
+void MIR::BuildFunc(ASTNodePointer subTree)
+{
+    MFunc f;
+    f.name = subTree->token.Text();
+    f.sym = subTree->symbol_ptr;
+    funcs.push_back(f);
+    this->func = &funcs.back();
+    this->defs.clear();
+
+    this->cur = this->NewBlock(true);
+    func->zero = this->Const(0);
+    func->mem0 = func->NewValue(true);
+    this->WriteVar(nullptr, cur, func->mem0);
+    // 参数的初值在调用者写入的位置
+    for (auto ptr = subTree->child[1]; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (ptr->IsTypeOf(StmtType::PARAM_INT))
+        {
+            int v = func->NewValue();
+            func->params[v] = ptr->symbol_ptr->memloc;
+            this->WriteVar(ptr->symbol_ptr, cur, v);
+        }
+    }
+
+    this->Stmt(subTree->child[2]);
+    if (!this->Terminated())
+    {
+        this->Emit(MInst(MInst::RET));
+    }
+
+    this->RemoveUnreachable(*func);
+    this->RemoveTrivialPhis(*func);
+}
+
+void MIR::Stmt(ASTNodePointer subTree)
+{
+    if (subTree == nullptr)
+    {
+        return;
+    }
+    auto child = subTree->child;
+    switch (subTree->stmtType)
+    {
+    case StmtType::COMP_STMT:
+    {
+        for (auto ptr = child[1]; ptr != nullptr; ptr = ptr->sibling)
+        {
+            this->Stmt(ptr);
+        }
+        break;
+    }
+    case StmtType::IF_STMT:
+    {
+        MInst br(MInst::BR);
+        br.args.push_back(this->Expr(child[0]));
+        int from = cur;
+        this->Emit(br);
+
+        int t = this->NewBlock(false);
+        this->AddEdge(from, t);
+        this->SealBlock(t);
+        cur = t;
+        this->Stmt(child[1]);
+        int tEnd = cur;
+        bool tDone = this->Terminated();
+
+        int e = -1, eEnd = -1;
+        bool eDone = false;
+        if (child[2] != nullptr)
+        {
+            e = this->NewBlock(false);
+            this->AddEdge(from, e);
+            this->SealBlock(e);
+            cur = e;
+            this->Stmt(child[2]);
+            eEnd = cur;
+            eDone = this->Terminated();
+        }
+
+        int join = this->NewBlock(false);
+        if (e < 0)
+        {
+            this->AddEdge(from, join);
+        }
+        func->blocks[from].insts.back().blocks = {t, (e < 0) ? join : e};
+        if (!tDone)
+        {
+            cur = tEnd;
+            this->Emit(MInst(MInst::JMP)).blocks = {join};
+            this->AddEdge(tEnd, join);
+        }
+        if (e >= 0 && !eDone)
+        {
+            cur = eEnd;
+            this->Emit(MInst(MInst::JMP)).blocks = {join};
+            this->AddEdge(eEnd, join);
+        }
+        this->SealBlock(join);
+        cur = join;
+        break;
+    }
+    case StmtType::ITER_STMT:
+    {
+        // 循环头在回边加入之前不能封闭
+        int header = this->NewBlock(false);
+        this->Emit(MInst(MInst::JMP)).blocks = {header};
+        this->AddEdge(cur, header);
+        cur = header;
+        MInst br(MInst::BR);
+        br.args.push_back(this->Expr(child[0]));
+        int hEnd = cur;
+        this->Emit(br);
+
+        int body = this->NewBlock(false);
+        this->AddEdge(hEnd, body);
+        this->SealBlock(body);
+        cur = body;
+        this->Stmt(child[1]);
+        if (!this->Terminated())
+        {
+            this->Emit(MInst(MInst::JMP)).blocks = {header};
+            this->AddEdge(cur, header);
+        }
+        this->SealBlock(header);
+
+        int exit = this->NewBlock(false);
+        this->AddEdge(hEnd, exit);
+        this->SealBlock(exit);
+        func->blocks[hEnd].insts.back().blocks = {body, exit};
+        cur = exit;
+        break;
+    }
+    case StmtType::RET_STMT:
+    {
+        MInst ret(MInst::RET);
+        if (child[0] != nullptr)
+        {
+            ret.args.push_back(this->Expr(child[0]));
+        }
+        this->Emit(ret);
+        // return 之后的语句不可达
+        cur = this->NewBlock(true);
+        break;
+    }
+    default:
+    {
+        this->Expr(subTree);
+        break;
+    }
+    }
+}
+
+int MIR::Expr(ASTNodePointer subTree)
+{
+    if (subTree == nullptr)
+    {
+        return func->zero;
+    }
+    auto child = subTree->child;
+    auto sym = subTree->symbol_ptr;
+    switch (subTree->stmtType)
+    {
+    case StmtType::NUM:
+    {
+        return this->Const(subTree->token.Value());
+    }
+    case StmtType::VAR_CALL:
+    {
+        if (sym->IsGlobal())
+        {
+            MInst inst(MInst::GLOAD);
+            inst.sym = sym;
+            inst.mem = this->ReadVar(nullptr, cur);
+            inst.dst = func->NewValue();
+            return this->Emit(inst).dst;
+        }
+        return this->ReadVar(sym, cur);
+    }
+    case StmtType::ARR_CALL:
+    {
+        MInst inst(MInst::LOAD);
+        inst.args.push_back(this->Expr(child[0]));
+        inst.sym = sym;
+        inst.attr = subTree->attr;
+        inst.mem = this->ReadVar(nullptr, cur);
+        inst.dst = func->NewValue();
+        return this->Emit(inst).dst;
+    }
+    case StmtType::ARR_SIZE:
+    {
+        MInst inst(MInst::SIZE);
+        inst.sym = sym;
+        inst.dst = func->NewValue();
+        return this->Emit(inst).dst;
+    }
+    case StmtType::ADDOP:
+    case StmtType::MULOP:
+    case StmtType::RELOP:
+    {
+        int l = (child[0] != nullptr) ? this->Expr(child[0]) : this->Const(0);
+        int r = this->Expr(child[1]);
+        MInst inst;
+        switch (subTree->token.type)
+        {
+        case TokenType::PLUS:
+            inst.op = MInst::ADD;
+            break;
+        case TokenType::MINUS:
+            inst.op = MInst::SUB;
+            break;
+        case TokenType::TIMES:
+            inst.op = MInst::MUL;
+            break;
+        case TokenType::DIVISION:
+            inst.op = MInst::DIV;
+            break;
+        default:
+            inst.op = MInst::CMP;
+            inst.imm = static_cast<long long>(subTree->token.type);
+            break;
+        }
+        inst.args = {l, r};
+        inst.attr = subTree->attr;
+        inst.dst = func->NewValue();
+        return this->Emit(inst).dst;
+    }
+    case StmtType::ASSIGN_STMT:
+    {
+        int v = this->Expr(child[1]);
+        auto left = child[0];
+        if (left->IsTypeOf(StmtType::ARR_CALL))
+        {
+            MInst inst(MInst::STORE);
+            inst.args.push_back(this->Expr(left->child[0]));
+            inst.args.push_back(v);
+            inst.sym = left->symbol_ptr;
+            inst.attr = left->attr;
+            inst.mem = this->ReadVar(nullptr, cur);
+            inst.mdst = func->NewValue(true);
+            this->WriteVar(nullptr, cur, this->Emit(inst).mdst);
+        }
+        else if (left->symbol_ptr->IsGlobal())
+        {
+            MInst inst(MInst::GSTORE);
+            inst.args.push_back(v);
+            inst.sym = left->symbol_ptr;
+            inst.mem = this->ReadVar(nullptr, cur);
+            inst.mdst = func->NewValue(true);
+            this->WriteVar(nullptr, cur, this->Emit(inst).mdst);
+        }
+        else
+        {
+            this->WriteVar(left->symbol_ptr, cur, v);
+        }
+        return v;
+    }
+    case StmtType::FUNC_CALL:
+    {
+        return this->Call(subTree);
+    }
+    default:
+        break;
+    }
+    return func->zero;
+}
+
+int MIR::Call(ASTNodePointer subTree)
+{
+    auto sym = subTree->symbol_ptr;
+    auto child = subTree->child;
+    if (sym->builtin == SymNode::INPUT)
+    {
+        MInst inst(MInst::IN);
+        inst.dst = func->NewValue();
+        return this->Emit(inst).dst;
+    }
+    if (sym->builtin == SymNode::OUTPUT)
+    {
+        MInst inst(MInst::OUT);
+        inst.args.push_back(this->Expr(child[0]));
+        this->Emit(inst);
+        return func->zero;
+    }
+
+    auto builtin = BuiltIn::Find(sym);
+    MInst inst((builtin != nullptr) ? MInst::VEC : MInst::CALL);
+    for (auto arg = child[0]; arg != nullptr; arg = arg->sibling)
+    {
+        if (arg->IsTypeOf(StmtType::VAR_CALL) && arg->symbol_ptr->IsArr())
+        {
+            // 数组按引用传递
+            MInst addr(MInst::ADDR);
+            addr.sym = arg->symbol_ptr;
+            addr.dst = func->NewValue();
+            inst.args.push_back(this->Emit(addr).dst);
+        }
+        else
+        {
+            inst.args.push_back(this->Expr(arg));
+        }
+    }
+    // 被调函数可能修改全局变量和数组，向量指令只读写数组
+    inst.sym = sym;
+    inst.mem = this->ReadVar(nullptr, cur);
+    inst.dst = (builtin == nullptr || builtin->HasResult()) ? func->NewValue() : -1;
+    inst.mdst = func->NewValue(true);
+    auto &call = this->Emit(inst);
+    this->WriteVar(nullptr, cur, call.mdst);
+    return (call.dst >= 0) ? call.dst : func->zero;
+}
+
+int MIR::NewBlock(bool sealed)
+{
+    MBlock b;
+    b.id = func->blocks.size();
+    b.sealed = sealed;
+    func->blocks.push_back(b);
+    return b.id;
+}
+
+void MIR::AddEdge(int from, int to)
+{
+    func->blocks[from].succs.push_back(to);
+    func->blocks[to].preds.push_back(from);
+}
+
+MInst &MIR::Emit(MInst inst)
+{
+    auto &insts = func->blocks[cur].insts;
+    insts.push_back(inst);
+    return insts.back();
+}
+
+int MIR::Const(long long v)
+{
+    MInst inst(MInst::CONST);
+    inst.imm = v;
+    inst.dst = func->NewValue();
+    func->consts[inst.dst] = v;
+    return this->Emit(inst).dst;
+}
+
+bool MIR::Terminated()
+{
+    auto &insts = func->blocks[cur].insts;
+    return !insts.empty() && insts.back().IsTerminator();
+}
+
+void MIR::WriteVar(SymNodePointer var, int block, int v)
+{
+    this->defs[var][block] = v;
+}
+
+int MIR::ReadVar(SymNodePointer var, int block)
+{
+    auto &d = this->defs[var];
+    auto iter = d.find(block);
+    if (iter != d.end())
+    {
+        return iter->second;
+    }
+    return this->ReadVarRecursive(var, block);
+}
+
+int MIR::ReadVarRecursive(SymNodePointer var, int block)
+{
+    int v = -1;
+    auto &b = func->blocks[block];
+    if (!b.sealed)
+    {
+        // 前驱还不完整，先放一个phi，封闭时再补全操作数
+        v = this->NewPhi(block, var);
+        func->blocks[block].incomplete[var] = v;
+    }
+    else if (b.preds.empty())
+    {
+        // 入口或不可达块：未初始化的变量
+        v = (var == nullptr) ? func->mem0 : func->zero;
+    }
+    else if (b.preds.size() == 1)
+    {
+        v = this->ReadVar(var, b.preds[0]);
+    }
+    else
+    {
+        v = this->NewPhi(block, var);
+        this->WriteVar(var, block, v);
+        this->AddPhiOperands(var, block, v);
+    }
+    this->WriteVar(var, block, v);
+    return v;
+}
+
+int MIR::NewPhi(int block, SymNodePointer var)
+{
+    MInst phi(MInst::PHI);
+    phi.dst = func->NewValue(var == nullptr);
+    phi.sym = var;
+    func->blocks[block].phis.push_back(phi);
+    return phi.dst;
+}
+
+void MIR::AddPhiOperands(SymNodePointer var, int block, int phi)
+{
+    vector<int> ops;
+    auto preds = func->blocks[block].preds;
+    for (auto p : preds)
+    {
+        ops.push_back(this->ReadVar(var, p));
+    }
+    for (auto &inst : func->blocks[block].phis)
+    {
+        if (inst.dst == phi)
+        {
+            inst.args = ops;
+        }
+    }
+}
+
+void MIR::SealBlock(int block)
+{
+    auto &incomplete = func->blocks[block].incomplete;
+    while (!incomplete.empty())
+    {
+        auto item = *incomplete.begin();
+        incomplete.erase(incomplete.begin());
+        this->AddPhiOperands(item.first, block, item.second);
+    }
+    func->blocks[block].sealed = true;
+}
+
+void MIR::RemoveUnreachable(MFunc &f)
+{
+    vector<int> stack{0};
+    f.blocks[0].reachable = true;
+    while (!stack.empty())
+    {
+        int b = stack.back();
+        stack.pop_back();
+        for (auto s : f.blocks[b].succs)
+        {
+            if (!f.blocks[s].reachable)
+            {
+                f.blocks[s].reachable = true;
+                stack.push_back(s);
+            }
+        }
+    }
+    for (auto &b : f.blocks)
+    {
+        if (!b.reachable)
+        {
+            b.phis.clear();
+            b.insts.clear();
+            b.succs.clear();
+            continue;
+        }
+        // 删除来自不可达块的边以及phi中对应的操作数
+        for (size_t k = b.preds.size(); k-- > 0;)
+        {
+            if (!f.blocks[b.preds[k]].reachable)
+            {
+                b.preds.erase(b.preds.begin() + k);
+                for (auto &phi : b.phis)
+                {
+                    phi.args.erase(phi.args.begin() + k);
+                }
+            }
+        }
+    }
+}
+
+void MIR::RemoveTrivialPhis(MFunc &f)
+{
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto &b : f.blocks)
+        {
+            for (auto &phi : b.phis)
+            {
+                if (phi.dead)
+                {
+                    continue;
+                }
+                // 操作数除自身外都相同的phi可以删除
+                int same = -1;
+                bool trivial = true;
+                for (auto a : phi.args)
+                {
+                    a = f.Find(a);
+                    if (a == phi.dst || a == same)
+                    {
+                        continue;
+                    }
+                    if (same >= 0)
+                    {
+                        trivial = false;
+                        break;
+                    }
+                    same = a;
+                }
+                if (trivial)
+                {
+                    if (same < 0)
+                    {
+                        same = f.isMem[phi.dst] ? f.mem0 : f.zero;
+                    }
+                    f.Replace(phi.dst, same);
+                    phi.dead = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+}
+
+void MIR::ResolveArgs(MFunc &f, MInst &inst)
+{
+    for (auto &a : inst.args)
+    {
+        a = f.Find(a);
+    }
+    if (inst.mem >= 0)
+    {
+        inst.mem = f.Find(inst.mem);
+    }
+}
+
+void MIR::Dominators(MFunc &f)
+{
+    // Cooper-Harvey-Kennedy 迭代算法
+    vector<int> order;
+    vector<int> rpo(f.blocks.size(), -1);
+    vector<bool> visited(f.blocks.size(), false);
+    vector<std::pair<int, size_t>> stack{{0, 0}};
+    visited[0] = true;
+    while (!stack.empty())
+    {
+        auto &top = stack.back();
+        auto &succs = f.blocks[top.first].succs;
+        if (top.second < succs.size())
+        {
+            int s = succs[top.second++];
+            if (!visited[s])
+            {
+                visited[s] = true;
+                stack.push_back({s, 0});
+            }
+        }
+        else
+        {
+            order.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        rpo[order[i]] = i;
+    }
+
+    for (auto &b : f.blocks)
+    {
+        b.idom = -1;
+        b.children.clear();
+    }
+    f.blocks[0].idom = 0;
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (size_t i = 1; i < order.size(); ++i)
+        {
+            auto &b = f.blocks[order[i]];
+            int idom = -1;
+            for (auto p : b.preds)
+            {
+                if (f.blocks[p].idom < 0)
+                {
+                    continue;
+                }
+                if (idom < 0)
+                {
+                    idom = p;
+                    continue;
+                }
+                // 求两个结点在支配树上的最近公共祖先
+                int x = p, y = idom;
+                while (x != y)
+                {
+                    while (rpo[x] > rpo[y])
+                    {
+                        x = f.blocks[x].idom;
+                    }
+                    while (rpo[y] > rpo[x])
+                    {
+                        y = f.blocks[y].idom;
+                    }
+                }
+                idom = x;
+            }
+            if (idom != b.idom)
+            {
+                b.idom = idom;
+                changed = true;
+            }
+        }
+    }
+    for (auto b : order)
+    {
+        if (b != 0)
+        {
+            f.blocks[f.blocks[b].idom].children.push_back(b);
+        }
+    }
+}
+
+void MIR::GVN()
+{
+    for (auto &f : funcs)
+    {
+        this->GVN(f);
+        this->Strength(f);
+        this->DCE(f);
+    }
+}
+
+void MIR::GVN(MFunc &f)
+{
+    this->Dominators(f);
+
+    // 沿支配树先序遍历，哈希表中只保留支配当前块的定义
+    map<string, int> table;
+    vector<std::pair<int, size_t>> stack{{0, 0}};
+    vector<vector<string>> added(f.blocks.size());
+    auto visit = [&](MBlock &b)
+    {
+        auto &keys = added[b.id];
+        for (auto &phi : b.phis)
+        {
+            if (phi.dead)
+            {
+                continue;
+            }
+            ResolveArgs(f, phi);
+            string key = "phi " + std::to_string(b.id);
+            for (auto a : phi.args)
+            {
+                key.append(" ").append(std::to_string(a));
+            }
+            auto iter = table.find(key);
+            if (iter != table.end())
+            {
+                f.Replace(phi.dst, iter->second);
+                phi.dead = true;
+                this->removed += 1;
+                continue;
+            }
+            table[key] = phi.dst;
+            keys.push_back(key);
+        }
+        for (auto &inst : b.insts)
+        {
+            ResolveArgs(f, inst);
+            if (this->Fold(f, inst))
+            {
+                this->removed += 1;
+                continue;
+            }
+            switch (inst.op)
+            {
+            case MInst::CONST:
+            case MInst::ADD:
+            case MInst::SUB:
+            case MInst::MUL:
+            case MInst::DIV:
+            case MInst::CMP:
+            case MInst::SHL:
+            case MInst::SHR:
+            case MInst::LOAD:
+            case MInst::GLOAD:
+            case MInst::ADDR:
+            case MInst::SIZE:
+                break;
+            default:
+                continue;
+            }
+            // 读内存的指令以内存状态作为操作数，中间没有写内存时才会相同
+            vector<int> args = inst.args;
+            if ((inst.op == MInst::ADD || inst.op == MInst::MUL) && args[0] > args[1])
+            {
+                std::swap(args[0], args[1]);
+            }
+            string key = std::to_string(inst.op) + " " + std::to_string(inst.imm) + " " +
+                         std::to_string(reinterpret_cast<uintptr_t>(inst.sym)) + " " + std::to_string(inst.mem);
+            for (auto a : args)
+            {
+                key.append(" ").append(std::to_string(a));
+            }
+            auto iter = table.find(key);
+            if (iter != table.end())
+            {
+                f.Replace(inst.dst, iter->second);
+                inst.dead = true;
+                this->removed += 1;
+                continue;
+            }
+            table[key] = inst.dst;
+            keys.push_back(key);
+        }
+    };
+
+    visit(f.blocks[0]);
+    while (!stack.empty())
+    {
+        auto &top = stack.back();
+        auto &children = f.blocks[top.first].children;
+        if (top.second < children.size())
+        {
+            int c = children[top.second++];
+            visit(f.blocks[c]);
+            stack.push_back({c, 0});
+        }
+        else
+        {
+            for (auto &key : added[top.first])
+            {
+                table.erase(key);
+            }
+            stack.pop_back();
+        }
+    }
+    this->RemoveTrivialPhis(f);
+}
+
+bool MIR::Fold(MFunc &f, MInst &inst)
+{
+    if (inst.op == MInst::SHL || inst.op == MInst::SHR)
+    {
+        auto c = f.consts.find(inst.args[0]);
+        if (c != f.consts.end())
+        {
+            int x = static_cast<int>(c->second);
+            inst.imm = (inst.op == MInst::SHL) ? static_cast<int>(static_cast<unsigned>(x) << inst.imm) : (x >> inst.imm);
+            inst.op = MInst::CONST;
+            inst.args.clear();
+            f.consts[inst.dst] = inst.imm;
+        }
+        return false;
+    }
+    switch (inst.op)
+    {
+    case MInst::ADD:
+    case MInst::SUB:
+    case MInst::MUL:
+    case MInst::DIV:
+    case MInst::CMP:
+        break;
+    default:
+        return false;
+    }
+    int a = inst.args[0], b = inst.args[1];
+    auto ca = f.consts.find(a);
+    auto cb = f.consts.find(b);
+    bool ka = (ca != f.consts.end());
+    bool kb = (cb != f.consts.end());
+
+    if (ka && kb)
+    {
+        // 按虚拟机的32位整数运算求值
+        int x = static_cast<int>(ca->second);
+        int y = static_cast<int>(cb->second);
+        long long v = 0;
+        switch (inst.op)
+        {
+        case MInst::ADD:
+            v = static_cast<int>(static_cast<unsigned>(x) + static_cast<unsigned>(y));
+            break;
+        case MInst::SUB:
+            v = static_cast<int>(static_cast<unsigned>(x) - static_cast<unsigned>(y));
+            break;
+        case MInst::MUL:
+            v = static_cast<int>(static_cast<unsigned>(x) * static_cast<unsigned>(y));
+            break;
+        case MInst::DIV:
+            if (y == 0 || (x == INT_MIN && y == -1))
+            {
+                return false;
+            }
+            v = x / y;
+            break;
+        default:
+        {
+            // 关系运算由减法和条件跳转实现
+            int d = static_cast<int>(static_cast<unsigned>(x) - static_cast<unsigned>(y));
+            switch (static_cast<TokenType>(inst.imm))
+            {
+            case TokenType::LT:
+                v = d < 0;
+                break;
+            case TokenType::LE:
+                v = d <= 0;
+                break;
+            case TokenType::GT:
+                v = d > 0;
+                break;
+            case TokenType::GE:
+                v = d >= 0;
+                break;
+            case TokenType::EQ:
+                v = d == 0;
+                break;
+            default:
+                v = d != 0;
+                break;
+            }
+            break;
+        }
+        }
+        inst.op = MInst::CONST;
+        inst.imm = v;
+        inst.args.clear();
+        f.consts[inst.dst] = v;
+        return false;
+    }
+
+    // 代数恒等式
+    int same = -1;
+    switch (inst.op)
+    {
+    case MInst::ADD:
+        same = (kb && cb->second == 0) ? a : ((ka && ca->second == 0) ? b : -1);
+        break;
+    case MInst::SUB:
+        same = (kb && cb->second == 0) ? a : -1;
+        break;
+    case MInst::MUL:
+        same = (kb && cb->second == 1) ? a : ((ka && ca->second == 1) ? b : -1);
+        break;
+    case MInst::DIV:
+        same = (kb && cb->second == 1) ? a : -1;
+        break;
+    default:
+        break;
+    }
+    if (same >= 0)
+    {
+        f.Replace(inst.dst, same);
+        inst.dead = true;
+        return true;
+    }
+
+    // 乘以2的幂改为左移，已证明非负的数除以2的幂改为右移
+    long long c = 0;
+    int x = -1;
+    if (inst.op == MInst::MUL && (ka || kb))
+    {
+        c = kb ? cb->second : ca->second;
+        x = kb ? a : b;
+    }
+    else if (inst.op == MInst::DIV && kb && (inst.attr & ASTNode::ATTR_NONNEG))
+    {
+        c = cb->second;
+        x = a;
+    }
+    if (inst.op == MInst::MUL && c == 0 && x >= 0)
+    {
+        inst.op = MInst::CONST;
+        inst.imm = 0;
+        inst.args.clear();
+        f.consts[inst.dst] = 0;
+        return false;
+    }
+    if (x >= 0 && c > 1 && c <= (1LL << 30) && (c & (c - 1)) == 0)
+    {
+        int shift = 0;
+        while ((1LL << shift) < c)
+        {
+            ++shift;
+        }
+        inst.op = (inst.op == MInst::MUL) ? MInst::SHL : MInst::SHR;
+        inst.imm = shift;
+        inst.args = {x};
+    }
+    return false;
+}
+
+void MIR::Strength(MFunc &f)
+{
+    /**
+     * 循环头的phi若每次经回边增加一个常数，就是基本归纳变量i
+     * 由 i 经加减常数、乘常数、左移得到的值都是 c*i+o 的形式
+     * 乘法改为每次迭代增加 c*step 的新归纳变量；
+     * 同一数组以同一 c*i 为下标的多次访问改为递增的元素地址，访问时只加常数偏移
+     */
+    struct IV
+    {
+        int base;
+        long long scale;
+        long long offset;
+    };
+    const long long LIMIT = 1LL << 20; // 系数和偏移保持在立即数范围内
+    auto wrap = [](long long v)
+    {
+        return static_cast<long long>(static_cast<int>(static_cast<unsigned>(v)));
+    };
+    vector<MInst> entry; // 新的常数，放在入口块
+    auto constant = [&](long long v)
+    {
+        MInst inst(MInst::CONST);
+        inst.imm = wrap(v);
+        inst.dst = f.NewValue();
+        f.consts[inst.dst] = inst.imm;
+        entry.push_back(inst);
+        return inst.dst;
+    };
+    auto dominates = [&](int a, int b)
+    {
+        while (b != a)
+        {
+            if (b <= 0 || f.blocks[b].idom < 0)
+            {
+                return false;
+            }
+            b = f.blocks[b].idom;
+        }
+        return true;
+    };
+    auto insertBefore = [](MBlock &b, vector<MInst> &insts)
+    {
+        auto pos = (!b.insts.empty() && b.insts.back().IsTerminator()) ? b.insts.end() - 1 : b.insts.end();
+        b.insts.insert(pos, insts.begin(), insts.end());
+        insts.clear();
+    };
+
+    for (size_t id = 0; id < f.blocks.size(); ++id)
+    {
+        if (!f.blocks[id].reachable || f.blocks[id].phis.empty())
+        {
+            continue;
+        }
+        // 只处理一个入口前驱、一条回边的循环
+        int pre = -1, latch = -1, kpre = -1, klat = -1;
+        bool ok = true;
+        auto &preds = f.blocks[id].preds;
+        for (size_t k = 0; k < preds.size(); ++k)
+        {
+            if (dominates(id, preds[k]))
+            {
+                ok = ok && (latch < 0);
+                latch = preds[k];
+                klat = k;
+            }
+            else
+            {
+                ok = ok && (pre < 0);
+                pre = preds[k];
+                kpre = k;
+            }
+        }
+        if (!ok || pre < 0 || latch < 0)
+        {
+            continue;
+        }
+        // 从回边逆向找到循环体
+        vector<bool> in(f.blocks.size(), false);
+        vector<int> body{static_cast<int>(id)};
+        in[id] = true;
+        if (!in[latch])
+        {
+            in[latch] = true;
+            body.push_back(latch);
+        }
+        for (size_t k = 1; k < body.size(); ++k)
+        {
+            for (auto p : f.blocks[body[k]].preds)
+            {
+                if (!in[p])
+                {
+                    in[p] = true;
+                    body.push_back(p);
+                }
+            }
+        }
+
+        map<int, MInst *> def;
+        for (auto b : body)
+        {
+            for (auto &inst : f.blocks[b].insts)
+            {
+                if (!inst.dead && inst.dst >= 0)
+                {
+                    ResolveArgs(f, inst);
+                    def[inst.dst] = &inst;
+                }
+            }
+        }
+        auto isConst = [&](int v, long long &c)
+        {
+            auto iter = f.consts.find(v);
+            if (iter == f.consts.end())
+            {
+                return false;
+            }
+            c = iter->second;
+            return true;
+        };
+
+        // 基本归纳变量
+        map<int, IV> iv;
+        map<int, long long> step;
+        map<int, int> init;
+        for (auto &phi : f.blocks[id].phis)
+        {
+            if (phi.dead || f.isMem[phi.dst])
+            {
+                continue;
+            }
+            auto d = def.find(f.Find(phi.args[klat]));
+            if (d == def.end())
+            {
+                continue;
+            }
+            auto &inc = *d->second;
+            long long c = 0;
+            int i = phi.dst;
+            bool found = false;
+            if (inc.op == MInst::ADD && inc.args[0] == i && isConst(inc.args[1], c))
+            {
+                found = true;
+            }
+            else if (inc.op == MInst::ADD && inc.args[1] == i && isConst(inc.args[0], c))
+            {
+                found = true;
+            }
+            else if (inc.op == MInst::SUB && inc.args[0] == i && isConst(inc.args[1], c))
+            {
+                c = -c;
+                found = true;
+            }
+            if (found && c != 0 && c > -LIMIT && c < LIMIT)
+            {
+                iv[i] = {i, 1, 0};
+                step[i] = c;
+                init[i] = f.Find(phi.args[kpre]);
+            }
+        }
+        if (iv.empty())
+        {
+            continue;
+        }
+
+        // 导出的归纳变量
+        bool changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (auto &d : def)
+            {
+                auto &inst = *d.second;
+                if (iv.count(inst.dst))
+                {
+                    continue;
+                }
+                long long c = 0;
+                IV r{-1, 0, 0};
+                switch (inst.op)
+                {
+                case MInst::ADD:
+                case MInst::SUB:
+                case MInst::MUL:
+                {
+                    int x = inst.args[0], y = inst.args[1];
+                    if (inst.op != MInst::SUB && !iv.count(x))
+                    {
+                        std::swap(x, y);
+                    }
+                    if (!iv.count(x) || !isConst(y, c))
+                    {
+                        break;
+                    }
+                    r = iv[x];
+                    if (inst.op == MInst::MUL)
+                    {
+                        r.scale *= c;
+                        r.offset *= c;
+                    }
+                    else
+                    {
+                        r.offset += (inst.op == MInst::ADD) ? c : -c;
+                    }
+                    break;
+                }
+                case MInst::SHL:
+                {
+                    if (iv.count(inst.args[0]) && inst.imm < 20)
+                    {
+                        r = iv[inst.args[0]];
+                        r.scale <<= inst.imm;
+                        r.offset <<= inst.imm;
+                    }
+                    break;
+                }
+                default:
+                    break;
+                }
+                if (r.base >= 0 && r.scale > -LIMIT && r.scale < LIMIT && r.offset > -LIMIT && r.offset < LIMIT)
+                {
+                    iv[inst.dst] = r;
+                    changed = true;
+                }
+            }
+        }
+
+        // 新的归纳变量 start + c*i，在前置块中求初值，在回边上递增
+        vector<MInst> preInsts, latchInsts, phis;
+        auto make = [&](int i, long long c, int start)
+        {
+            int t = -1;
+            long long v = 0;
+            bool zero = false;
+            if (isConst(init[i], v))
+            {
+                zero = (wrap(c * v) == 0);
+                t = constant(c * v);
+            }
+            else if (c == 1)
+            {
+                t = init[i];
+            }
+            else
+            {
+                MInst mul(MInst::MUL);
+                mul.args = {init[i], constant(c)};
+                mul.dst = f.NewValue();
+                preInsts.push_back(mul);
+                t = mul.dst;
+            }
+            if (start >= 0 && zero)
+            {
+                t = start;
+            }
+            else if (start >= 0)
+            {
+                MInst add(MInst::ADD);
+                add.args = {start, t};
+                add.dst = f.NewValue();
+                preInsts.push_back(add);
+                t = add.dst;
+            }
+            MInst phi(MInst::PHI);
+            phi.dst = f.NewValue();
+            phi.args.resize(f.blocks[id].preds.size());
+            phi.args[kpre] = t;
+            MInst inc(MInst::ADD);
+            inc.args = {phi.dst, constant(c * step[i])};
+            inc.dst = f.NewValue();
+            latchInsts.push_back(inc);
+            phi.args[klat] = inc.dst;
+            phis.push_back(phi);
+            return phi.dst;
+        };
+        auto safe = [&](const MInst &inst)
+        {
+            bool low = (this->boundsCheck == IR::BOUNDS_NONE) || (inst.attr & ASTNode::ATTR_LOW_SAFE);
+            bool high = (this->boundsCheck != IR::BOUNDS_FULL) || (inst.attr & ASTNode::ATTR_HIGH_SAFE);
+            return low && high;
+        };
+
+        // 数组访问：同一数组、同一 c*i 的访问不少于两次时改用元素地址
+        map<std::tuple<SymNodePointer, int, long long>, vector<MInst *>> groups;
+        for (auto b : body)
+        {
+            for (auto &inst : f.blocks[b].insts)
+            {
+                if (inst.dead || (inst.op != MInst::LOAD && inst.op != MInst::STORE) || !safe(inst))
+                {
+                    continue;
+                }
+                ResolveArgs(f, inst);
+                auto r = iv.find(inst.args[0]);
+                if (r != iv.end())
+                {
+                    groups[{inst.sym, r->second.base, r->second.scale}].push_back(&inst);
+                }
+            }
+        }
+        for (auto &g : groups)
+        {
+            if (g.second.size() < 2)
+            {
+                continue;
+            }
+            MInst addr(MInst::ADDR);
+            addr.sym = std::get<0>(g.first);
+            addr.dst = f.NewValue();
+            preInsts.push_back(addr);
+            int p = make(std::get<1>(g.first), std::get<2>(g.first), addr.dst);
+            for (auto inst : g.second)
+            {
+                inst->imm = iv[inst->args[0]].offset;
+                inst->args[0] = p;
+                inst->op = (inst->op == MInst::LOAD) ? MInst::LOADP : MInst::STOREP;
+            }
+        }
+
+        // 乘法：结果仍被使用的 c*i+o 改为新归纳变量加常数
+        // 改为按地址访问后下标计算可能已经无用，不计入使用次数
+        map<int, int> uses;
+        vector<MInst *> pure;
+        for (auto &b : f.blocks)
+        {
+            for (auto *list : {&b.phis, &b.insts})
+            {
+                for (auto &inst : *list)
+                {
+                    for (auto a : inst.args)
+                    {
+                        uses[f.Find(a)] += inst.dead ? 0 : 1;
+                    }
+                    if (!inst.dead && inst.dst >= 0 && inst.IsPure())
+                    {
+                        pure.push_back(&inst);
+                    }
+                }
+            }
+        }
+        changed = true;
+        while (changed)
+        {
+            changed = false;
+            for (auto &inst : pure)
+            {
+                if (inst != nullptr && uses[inst->dst] == 0)
+                {
+                    for (auto a : inst->args)
+                    {
+                        uses[f.Find(a)] -= 1;
+                    }
+                    inst = nullptr;
+                    changed = true;
+                }
+            }
+        }
+        map<std::pair<int, long long>, int> scaled;
+        for (auto &d : def)
+        {
+            auto &inst = *d.second;
+            if ((inst.op != MInst::MUL && inst.op != MInst::SHL) || inst.dead || !iv.count(inst.dst) || uses[inst.dst] == 0)
+            {
+                continue;
+            }
+            auto r = iv[inst.dst];
+            auto key = std::make_pair(r.base, r.scale);
+            if (!scaled.count(key))
+            {
+                scaled[key] = make(r.base, r.scale, -1);
+            }
+            if (r.offset == 0)
+            {
+                f.Replace(inst.dst, scaled[key]);
+                inst.dead = true;
+            }
+            else
+            {
+                inst.op = MInst::ADD;
+                inst.imm = 0;
+                inst.args = {scaled[key], constant(r.offset)};
+            }
+        }
+
+        insertBefore(f.blocks[pre], preInsts);
+        insertBefore(f.blocks[latch], latchInsts);
+        auto &hp = f.blocks[id].phis;
+        hp.insert(hp.end(), phis.begin(), phis.end());
+    }
+    auto &first = f.blocks[0].insts;
+    first.insert(first.begin(), entry.begin(), entry.end());
+}
+
+void MIR::DCE(MFunc &f)
+{
+    vector<int> uses(f.nvalue, 0);
+    auto count = [&](MInst &inst, int d)
+    {
+        for (auto a : inst.args)
+        {
+            uses[a] += d;
+        }
+        if (inst.mem >= 0)
+        {
+            uses[inst.mem] += d;
+        }
+    };
+    for (auto &b : f.blocks)
+    {
+        for (auto &phi : b.phis)
+        {
+            if (!phi.dead)
+            {
+                ResolveArgs(f, phi);
+                count(phi, 1);
+            }
+        }
+        for (auto &inst : b.insts)
+        {
+            if (!inst.dead)
+            {
+                ResolveArgs(f, inst);
+                count(inst, 1);
+            }
+        }
+    }
+
+    // 不会越界的读取和除数非零的除法也可以删除
+    auto removable = [&](MInst &inst)
+    {
+        if (inst.IsPure())
+        {
+            return true;
+        }
+        if (inst.op == MInst::DIV)
+        {
+            auto c = f.consts.find(inst.args[1]);
+            return c != f.consts.end() && c->second != 0;
+        }
+        if (inst.op == MInst::LOADP)
+        {
+            // 只有已证明不越界的访问才会改为按地址读取
+            return true;
+        }
+        if (inst.op == MInst::LOAD)
+        {
+            bool low = (this->boundsCheck == IR::BOUNDS_NONE) || (inst.attr & ASTNode::ATTR_LOW_SAFE);
+            bool high = (this->boundsCheck != IR::BOUNDS_FULL) || (inst.attr & ASTNode::ATTR_HIGH_SAFE);
+            return low && high;
+        }
+        return false;
+    };
+
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto &b : f.blocks)
+        {
+            for (auto *list : {&b.phis, &b.insts})
+            {
+                for (auto &inst : *list)
+                {
+                    if (!inst.dead && inst.dst >= 0 && uses[inst.dst] == 0 && removable(inst))
+                    {
+                        inst.dead = true;
+                        count(inst, -1);
+                        changed = true;
+                        this->removed += (inst.op == MInst::CONST || inst.op == MInst::PHI) ? 0 : 1;
+                    }
+                }
+            }
+        }
+    }
+
+    for (auto &b : f.blocks)
+    {
+        b.insts.erase(std::remove_if(b.insts.begin(), b.insts.end(), [](const MInst &i)
+                                     { return i.dead; }),
+                      b.insts.end());
+        b.phis.erase(std::remove_if(b.phis.begin(), b.phis.end(), [](const MInst &i)
+                                    { return i.dead; }),
+                     b.phis.end());
+    }
+}
+
+void MIR::SplitCriticalEdges(MFunc &f)
+{
+    size_t n = f.blocks.size();
+    for (size_t id = 0; id < n; ++id)
+    {
+        if (!f.blocks[id].reachable || f.blocks[id].phis.empty() || f.blocks[id].preds.size() < 2)
+        {
+            continue;
+        }
+        for (size_t k = 0; k < f.blocks[id].preds.size(); ++k)
+        {
+            int p = f.blocks[id].preds[k];
+            if (f.blocks[p].succs.size() < 2)
+            {
+                continue;
+            }
+            // 在边上插入一个只有跳转的块，phi的复制放在其中
+            MBlock nb;
+            nb.id = f.blocks.size();
+            nb.reachable = true;
+            nb.preds = {p};
+            nb.succs = {static_cast<int>(id)};
+            MInst jmp(MInst::JMP);
+            jmp.blocks = {static_cast<int>(id)};
+            nb.insts.push_back(jmp);
+            f.blocks.push_back(nb);
+
+            auto &pred = f.blocks[p];
+            auto &bb = f.blocks[id];
+            std::replace(pred.succs.begin(), pred.succs.end(), static_cast<int>(id), nb.id);
+            auto &term = pred.insts.back().blocks;
+            std::replace(term.begin(), term.end(), static_cast<int>(id), nb.id);
+            bb.preds[k] = nb.id;
+            f.order.insert(std::find(f.order.begin(), f.order.end(), p) + 1, nb.id);
+        }
+    }
+}
+
+void MIR::DestructSSA(MFunc &f)
+{
+    // phi 变为前驱末尾的并行复制
+    for (auto &b : f.blocks)
+    {
+        if (b.phis.empty())
+        {
+            continue;
+        }
+        for (size_t k = 0; k < b.preds.size(); ++k)
+        {
+            MInst copy(MInst::COPY);
+            for (auto &phi : b.phis)
+            {
+                int src = f.Find(phi.args[k]);
+                if (!f.isMem[phi.dst] && src != phi.dst)
+                {
+                    copy.args.push_back(phi.dst);
+                    copy.args.push_back(src);
+                }
+            }
+            if (!copy.args.empty())
+            {
+                auto &insts = f.blocks[b.preds[k]].insts;
+                insts.insert(insts.end() - 1, copy);
+            }
+        }
+        b.phis.clear();
+    }
+}
+
+void MIR::Lower(IR &ir)
+{
+    map<int, string> calls;
+    for (auto &f : funcs)
+    {
+        f.order.clear();
+        for (auto &b : f.blocks)
+        {
+            if (b.reachable)
+            {
+                f.order.push_back(b.id);
+            }
+        }
+        this->SplitCriticalEdges(f);
+        this->DestructSSA(f);
+        this->LowerFunc(ir, f, calls);
+    }
+    // 回填函数调用的入口地址
+    for (auto &c : calls)
+    {
+        ir.qps[c.first].addr2 = to_string(ir.inst_offset.at(c.second));
+    }
+}
+
+int MIR::PackSlots(MFunc &f, vector<int> &slot, const map<int, int> &coalesce, int base)
+{
+    // 共用位置的值以复制目标为代表
+    auto rep = [&](int v)
+    {
+        auto c = coalesce.find(v);
+        return (c == coalesce.end()) ? v : c->second;
+    };
+    auto operands = [](const MInst &inst, vector<int> &use, vector<int> &def)
+    {
+        use.clear();
+        def.clear();
+        for (size_t k = 0; k < inst.args.size(); ++k)
+        {
+            bool copyDst = (inst.op == MInst::COPY) && (k % 2 == 0);
+            (copyDst ? def : use).push_back(inst.args[k]);
+        }
+        if (inst.dst >= 0)
+        {
+            def.push_back(inst.dst);
+        }
+    };
+
+    // 按排布顺序编号，块末尾额外占一个位置表示出口
+    int n = f.nvalue;
+    map<int, std::pair<int, int>> range;
+    int pos = 0;
+    for (auto id : f.order)
+    {
+        range[id] = {pos, pos + static_cast<int>(f.blocks[id].insts.size())};
+        pos += f.blocks[id].insts.size() + 1;
+    }
+
+    // 活跃变量分析
+    vector<int> use, def;
+    map<int, vector<bool>> liveIn, liveOut;
+    for (auto id : f.order)
+    {
+        liveIn[id].assign(n, false);
+        liveOut[id].assign(n, false);
+    }
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto it = f.order.rbegin(); it != f.order.rend(); ++it)
+        {
+            auto &b = f.blocks[*it];
+            vector<bool> live(n, false);
+            for (auto s : b.succs)
+            {
+                auto in = liveIn.find(s);
+                for (int v = 0; in != liveIn.end() && v < n; ++v)
+                {
+                    live[v] = live[v] || in->second[v];
+                }
+            }
+            liveOut[*it] = live;
+            for (auto i = b.insts.rbegin(); i != b.insts.rend(); ++i)
+            {
+                operands(*i, use, def);
+                for (auto d : def)
+                {
+                    live[d] = false;
+                }
+                for (auto u : use)
+                {
+                    live[u] = true;
+                }
+            }
+            if (live != liveIn[*it])
+            {
+                liveIn[*it] = live;
+                changed = true;
+            }
+        }
+    }
+
+    // 生存期取覆盖全部活跃位置的区间
+    vector<int> start(n, INT_MAX), end(n, -1);
+    auto extend = [&](int v, int p)
+    {
+        v = rep(v);
+        start[v] = std::min(start[v], p);
+        end[v] = std::max(end[v], p);
+    };
+    for (auto id : f.order)
+    {
+        auto r = range[id];
+        for (int v = 0; v < n; ++v)
+        {
+            if (liveIn[id][v])
+            {
+                extend(v, r.first);
+            }
+            if (liveOut[id][v])
+            {
+                extend(v, r.second);
+            }
+        }
+        auto &insts = f.blocks[id].insts;
+        for (size_t i = 0; i < insts.size(); ++i)
+        {
+            operands(insts[i], use, def);
+            for (auto v : use)
+            {
+                extend(v, r.first + i);
+            }
+            for (auto v : def)
+            {
+                extend(v, r.first + i);
+            }
+        }
+    }
+
+    // 按起点排序依次分配，生存期已经结束的位置可以重用
+    vector<int> order;
+    for (int v = 0; v < n; ++v)
+    {
+        if (slot[v] == SLOT_NEED && rep(v) == v)
+        {
+            order.push_back(v);
+        }
+    }
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return start[a] < start[b] || (start[a] == start[b] && a < b); });
+    int frame = base;
+    std::set<int> free;
+    vector<std::pair<int, int>> active; // (生存期终点, 位置)
+    for (auto v : order)
+    {
+        for (size_t k = 0; k < active.size();)
+        {
+            if (active[k].first < start[v])
+            {
+                free.insert(active[k].second);
+                active.erase(active.begin() + k);
+                continue;
+            }
+            ++k;
+        }
+        if (free.empty())
+        {
+            slot[v] = frame++;
+        }
+        else
+        {
+            slot[v] = *free.begin();
+            free.erase(free.begin());
+        }
+        active.push_back({end[v], slot[v]});
+    }
+    for (int v = 0; v < n; ++v)
+    {
+        if (slot[v] == SLOT_NEED)
+        {
+            slot[v] = slot[rep(v)];
+        }
+    }
+    return frame;
+}
+
+void MIR::LowerFunc(IR &ir, MFunc &f, map<int, string> &calls)
+{
+    const string &AC = IR::AC, &AC1 = IR::AC1, &BP = IR::BP, &FP = IR::FP, &GP = IR::GP, &PC = IR::PC;
+
+    // 第一个装入AC的操作数
+    auto first = [](const MInst &inst)
+    {
+        switch (inst.op)
+        {
+        case MInst::ADD:
+        case MInst::SUB:
+        case MInst::MUL:
+        case MInst::DIV:
+        case MInst::CMP:
+        case MInst::LOAD:
+        case MInst::STORE:
+        case MInst::GSTORE:
+        case MInst::OUT:
+        case MInst::RET:
+        case MInst::BR:
+        case MInst::CALL:
+        case MInst::SHL:
+        case MInst::SHR:
+            return inst.args.empty() ? -1 : inst.args[0];
+        case MInst::STOREP:
+            return inst.args[1];
+        default:
+            break;
+        }
+        return -1;
+    };
+
+    // 统计使用次数，结果只被下一条指令作为第一个操作数使用时留在AC中，不写回栈帧
+    vector<int> uses(f.nvalue, 0);
+    map<int, SymNodePointer> addrOf; // 数组基址来自哪个数组
+    for (auto id : f.order)
+    {
+        for (auto &inst : f.blocks[id].insts)
+        {
+            for (auto a : inst.args)
+            {
+                uses[a] += 1;
+            }
+            if (inst.op == MInst::ADDR)
+            {
+                addrOf[inst.dst] = inst.sym;
+            }
+        }
+    }
+    int nparam = IR::ParamCount(f.sym);
+    // 块末尾的复制：源值在本块定义、只被复制使用，且定义之后不再读取目标时，二者共用一个位置
+    // 循环变量的递增因此直接写回原来的位置
+    map<int, int> coalesce;
+    for (auto id : f.order)
+    {
+        auto &insts = f.blocks[id].insts;
+        if (insts.size() < 2 || insts[insts.size() - 2].op != MInst::COPY)
+        {
+            continue;
+        }
+        auto &copy = insts[insts.size() - 2];
+        for (size_t k = 0; k < copy.args.size(); k += 2)
+        {
+            int d = copy.args[k], src = copy.args[k + 1];
+            if (uses[src] != 1 || f.consts.count(src) || f.params.count(src))
+            {
+                continue;
+            }
+            size_t j = 0;
+            while (j + 2 < insts.size() && insts[j].dst != src)
+            {
+                ++j;
+            }
+            if (j + 2 >= insts.size())
+            {
+                continue;
+            }
+            bool read = false;
+            for (size_t t = j + 1; t + 1 < insts.size(); ++t)
+            {
+                auto &a = insts[t].args;
+                for (size_t q = (insts[t].op == MInst::COPY) ? 1 : 0; q < a.size(); q += (insts[t].op == MInst::COPY) ? 2 : 1)
+                {
+                    read = read || (a[q] == d);
+                }
+            }
+            if (!read)
+            {
+                coalesce[src] = d;
+            }
+        }
+    }
+
+    vector<bool> forward(f.nvalue, false);
+    vector<int> slot(f.nvalue, INT_MIN);
+    int frame = f.sym->memloc;
+    for (auto &p : f.params)
+    {
+        slot[p.first] = p.second;
+    }
+    for (auto id : f.order)
+    {
+        auto &insts = f.blocks[id].insts;
+        for (size_t i = 0; i < insts.size(); ++i)
+        {
+            auto &inst = insts[i];
+            if (inst.op == MInst::COPY)
+            {
+                for (size_t k = 0; k < inst.args.size(); k += 2)
+                {
+                    if (slot[inst.args[k]] == INT_MIN)
+                    {
+                        slot[inst.args[k]] = SLOT_NEED;
+                    }
+                }
+                continue;
+            }
+            int d = inst.dst;
+            if (d < 0 || inst.op == MInst::CONST || uses[d] == 0 || slot[d] != INT_MIN)
+            {
+                continue;
+            }
+            auto co = coalesce.find(d);
+            if (co != coalesce.end())
+            {
+                if (slot[co->second] == INT_MIN)
+                {
+                    slot[co->second] = SLOT_NEED;
+                }
+                slot[d] = SLOT_NEED;
+                continue;
+            }
+            size_t j = i + 1;
+            while (j < insts.size() && insts[j].op == MInst::CONST)
+            {
+                ++j;
+            }
+            if (uses[d] == 1 && j < insts.size() && first(insts[j]) == d)
+            {
+                forward[d] = true;
+                continue;
+            }
+            slot[d] = SLOT_NEED;
+        }
+    }
+    frame = this->PackSlots(f, slot, coalesce, frame);
+    int scratch = frame++; // 并行复制出现环时使用
+    int top = frame;       // 实参从这里开始存放
+
+    ir.inst_offset[f.name] = ir.qps.size();
+    int entry = ir.qps.size();
+    ir.frameTop = frame;
+    if (this->boundsCheck == IR::BOUNDS_FULL)
+    {
+        ir.GenArrHeader(f.sym, FP);
+    }
+
+    int acValue = -1;  // AC中保存的值
+    bool tail = false; // 已经生成尾调用，省去紧随的返回
+    auto load = [&](int v, const string &reg)
+    {
+        auto c = f.consts.find(v);
+        if (c != f.consts.end())
+        {
+            ir.EmitRM("LDC", reg, to_string(c->second), "0");
+        }
+        else if (reg == AC && acValue == v)
+        {
+            return;
+        }
+        else
+        {
+            // 没有存储位置的值只能在AC中直接使用
+            assert(slot[v] != INT_MIN);
+            ir.EmitRM("LD", reg, to_string(slot[v]), FP);
+        }
+        if (reg == AC)
+        {
+            acValue = v;
+        }
+    };
+    auto def = [&](int v)
+    {
+        acValue = v;
+        if (v >= 0 && slot[v] != INT_MIN)
+        {
+            ir.EmitRM("ST", AC, to_string(slot[v]), FP);
+        }
+    };
+    auto base = [&](SymNodePointer sym, const string &reg)
+    {
+        if (sym->IsGlobal())
+        {
+            ir.EmitRM("LDA", reg, to_string(sym->memloc), GP);
+        }
+        else if (sym->IsParam())
+        {
+            ir.EmitRM("LD", reg, to_string(sym->memloc), FP);
+        }
+        else
+        {
+            ir.EmitRM("LDA", reg, to_string(sym->memloc), FP);
+        }
+    };
+    auto isConst = [&](int v, long long &c)
+    {
+        auto iter = f.consts.find(v);
+        if (iter == f.consts.end())
+        {
+            return false;
+        }
+        c = iter->second;
+        return true;
+    };
+    // 数组地址计算，返回常数下标(不需要检查时)
+    auto address = [&](const MInst &inst, long long &offset)
+    {
+        auto sym = inst.sym;
+        long long c = 0;
+        bool k = isConst(inst.args[0], c);
+        int size = sym->GetArrSize();
+        bool low = (this->boundsCheck != IR::BOUNDS_NONE) && !(inst.attr & ASTNode::ATTR_LOW_SAFE) && !(k && c >= 0);
+        bool high = (this->boundsCheck == IR::BOUNDS_FULL) && !(inst.attr & ASTNode::ATTR_HIGH_SAFE) &&
+                    !(k && size > 0 && c < size);
+        if (k && !low && !high && c <= INT_MAX)
+        {
+            base(sym, BP);
+            offset = c;
+            return true;
+        }
+        load(inst.args[0], AC);
+        if (low)
+        {
+            ir.EmitRM("JGE", AC, "1", PC, "Check Negative Array Offset");
+            ir.EmitRO("HALT", "-1", "0", "0", "Shutdown If Offset Is Negative");
+        }
+        base(sym, BP);
+        if (high)
+        {
+            if (sym->IsParam())
+            {
+                ir.EmitRM("LD", AC1, "-1", BP, "Load Arr Size");
+                ir.EmitRO("SUB", AC1, AC, AC1);
+            }
+            else
+            {
+                ir.EmitRM("LDA", AC1, to_string(-size), AC);
+            }
+            ir.EmitRM("JLT", AC1, "1", PC, "Check Array Offset Upper Bound");
+            ir.EmitRO("HALT", "-2", "0", "0", "Shutdown If Offset Is Out Of Range");
+        }
+        ir.EmitRO("ADD", BP, AC, BP);
+        offset = 0;
+        return false;
+    };
+
+    auto jop = [](TokenType t, bool negate)
+    {
+        switch (t)
+        {
+        case TokenType::LT:
+            return negate ? "JGE" : "JLT";
+        case TokenType::LE:
+            return negate ? "JGT" : "JLE";
+        case TokenType::GT:
+            return negate ? "JLE" : "JGT";
+        case TokenType::GE:
+            return negate ? "JLT" : "JGE";
+        case TokenType::EQ:
+            return negate ? "JNE" : "JEQ";
+        default:
+            break;
+        }
+        return negate ? "JEQ" : "JNE";
+    };
+
+    map<int, int> start;               // 基本块的第一条指令
+    vector<std::pair<int, int>> jumps; // 待回填的跳转
+    for (size_t o = 0; o < f.order.size(); ++o)
+    {
+        auto &b = f.blocks[f.order[o]];
+        int next = (o + 1 < f.order.size()) ? f.order[o + 1] : -1;
+        start[b.id] = ir.qps.size();
+        acValue = -1;
+        TokenType fused = TokenType::NONE; // 与条件跳转合并的比较
+        auto &insts = b.insts;
+        for (size_t i = 0; i < insts.size(); ++i)
+        {
+            auto &inst = insts[i];
+            auto &args = inst.args;
+            long long c = 0;
+            switch (inst.op)
+            {
+            case MInst::CONST:
+                break;
+            case MInst::ADD:
+            case MInst::SUB:
+            {
+                bool add = (inst.op == MInst::ADD);
+                if (isConst(args[1], c) && c > INT_MIN && c <= INT_MAX)
+                {
+                    load(args[0], AC);
+                    ir.EmitRM("LDA", AC, to_string(add ? c : -c), AC);
+                }
+                else if (add && isConst(args[0], c) && c <= INT_MAX)
+                {
+                    load(args[1], AC);
+                    ir.EmitRM("LDA", AC, to_string(c), AC);
+                }
+                else
+                {
+                    load(args[0], AC);
+                    load(args[1], AC1);
+                    ir.EmitRO(add ? "ADD" : "SUB", AC, AC, AC1);
+                }
+                def(inst.dst);
+                break;
+            }
+            case MInst::MUL:
+            case MInst::DIV:
+            {
+                load(args[0], AC);
+                load(args[1], AC1);
+                ir.EmitRO((inst.op == MInst::MUL) ? "MUL" : "DIV", AC, AC, AC1);
+                def(inst.dst);
+                break;
+            }
+            case MInst::CMP:
+            {
+                load(args[0], AC);
+                if (!(isConst(args[1], c) && c == 0))
+                {
+                    load(args[1], AC1);
+                    ir.EmitRO("SUB", AC, AC, AC1);
+                }
+                auto relop = static_cast<TokenType>(inst.imm);
+                size_t j = i + 1;
+                while (j < insts.size() && insts[j].op == MInst::CONST)
+                {
+                    ++j;
+                }
+                if (forward[inst.dst] && j < insts.size() && insts[j].op == MInst::BR)
+                {
+                    // 比较结果只用于条件跳转
+                    fused = relop;
+                    acValue = -1;
+                    break;
+                }
+                ir.EmitRM(jop(relop, false), AC, "2", PC, "Relop");
+                ir.EmitRM("LDC", AC, "0", "0", "Relop False: Set AC 0");
+                ir.EmitRM("LDA", PC, "1", PC);
+                ir.EmitRM("LDC", AC, "1", "0", "Relop True: Set AC 1");
+                def(inst.dst);
+                break;
+            }
+            case MInst::SHL:
+            case MInst::SHR:
+            {
+                load(args[0], AC);
+                ir.EmitRM((inst.op == MInst::SHL) ? "SHL" : "SHR", AC, to_string(inst.imm), AC);
+                def(inst.dst);
+                break;
+            }
+            case MInst::LOAD:
+            {
+                address(inst, c);
+                ir.EmitRM("LD", AC, to_string(c), BP);
+                def(inst.dst);
+                break;
+            }
+            case MInst::LOADP:
+            {
+                load(args[0], BP);
+                ir.EmitRM("LD", AC, to_string(inst.imm), BP);
+                def(inst.dst);
+                break;
+            }
+            case MInst::STOREP:
+            {
+                load(args[1], AC);
+                load(args[0], BP);
+                ir.EmitRM("ST", AC, to_string(inst.imm), BP, "Assign End");
+                break;
+            }
+            case MInst::STORE:
+            {
+                address(inst, c);
+                acValue = -1;
+                load(args[1], AC);
+                ir.EmitRM("ST", AC, to_string(c), BP, "Assign End");
+                break;
+            }
+            case MInst::GLOAD:
+            {
+                ir.EmitRM("LD", AC, to_string(inst.sym->memloc), GP);
+                def(inst.dst);
+                break;
+            }
+            case MInst::GSTORE:
+            {
+                load(args[0], AC);
+                ir.EmitRM("ST", AC, to_string(inst.sym->memloc), GP, "Assign End");
+                break;
+            }
+            case MInst::ADDR:
+            {
+                base(inst.sym, AC);
+                def(inst.dst);
+                break;
+            }
+            case MInst::SIZE:
+            {
+                if (inst.sym->IsParam())
+                {
+                    ir.EmitRM("LD", BP, to_string(inst.sym->memloc), FP);
+                    ir.EmitRM("LD", AC, "-1", BP, "Load Arr Size");
+                }
+                else
+                {
+                    ir.EmitRM("LDC", AC, to_string(inst.sym->GetArrSize()), "0", "Load Arr Size");
+                }
+                def(inst.dst);
+                break;
+            }
+            case MInst::CALL:
+            {
+                int n = args.size();
+                size_t j = i + 1;
+                while (j < insts.size() && insts[j].op == MInst::CONST)
+                {
+                    ++j;
+                }
+                bool local = false;
+                for (auto a : args)
+                {
+                    auto iter = addrOf.find(a);
+                    local = local || (iter != addrOf.end() && !iter->second->IsGlobal() && !iter->second->IsParam());
+                }
+                if (ir.tailCall && j < insts.size() && insts[j].op == MInst::RET && insts[j].args.size() == 1 &&
+                    insts[j].args[0] == inst.dst && n <= nparam && !local)
+                {
+                    // 尾调用：实参写入当前的参数区，保存的返回地址和FP不变
+                    // 读取会被覆盖的参数的实参先存到临时位置
+                    // 只在AC中的实参会被暂存时的读取覆盖，先存到参数暂存区之后
+                    vector<int> temp(n, INT_MIN);
+                    for (int k = 0; k < n; ++k)
+                    {
+                        if (!f.consts.count(args[k]) && slot[args[k]] == INT_MIN)
+                        {
+                            load(args[k], AC);
+                            temp[k] = top + n + k;
+                            ir.EmitRM("ST", AC, to_string(temp[k]), FP);
+                        }
+                    }
+                    vector<bool> staged(n, false);
+                    for (int k = 0; k < n; ++k)
+                    {
+                        int s = (f.consts.count(args[k]) || temp[k] != INT_MIN) ? INT_MIN : slot[args[k]];
+                        staged[k] = (s >= -2 - n && s <= -3 && s != -2 - n + k);
+                        if (staged[k])
+                        {
+                            load(args[k], AC);
+                            ir.EmitRM("ST", AC, to_string(top + k), FP);
+                        }
+                    }
+                    int begin = ir.qps.size();
+                    for (int k = 0; k < n; ++k)
+                    {
+                        if (staged[k] || temp[k] != INT_MIN)
+                        {
+                            ir.EmitRM("LD", AC, to_string(staged[k] ? top + k : temp[k]), FP);
+                            acValue = -1;
+                        }
+                        else if (!f.consts.count(args[k]) && slot[args[k]] == -2 - n + k)
+                        {
+                            continue;
+                        }
+                        else
+                        {
+                            load(args[k], AC);
+                        }
+                        ir.EmitRM("ST", AC, to_string(-2 - n + k), FP);
+                    }
+                    if (begin != static_cast<int>(ir.qps.size()))
+                    {
+                        ir.EmitComment("Tail Call: Overwrite Params", begin);
+                    }
+                    int jmp = ir.EmitRM("LDC", PC, "?", "0", "Tail Call: Jump To " + string(inst.sym->token_ptr->Text()));
+                    ir.qps[jmp].ctrl = Quadruple::CTRL_TAIL;
+                    calls[jmp] = inst.sym->token_ptr->Text();
+                    tail = true;
+                    break;
+                }
+                for (int k = 0; k < n; ++k)
+                {
+                    load(args[k], AC);
+                    ir.EmitRM("ST", AC, to_string(top + k), FP);
+                }
+                int ret = ir.EmitRM("LDC", AC, to_string(ir.qps.size() + 5), "0", "Call: Load Return Addr");
+                ir.qps[ret].ctrl = Quadruple::CTRL_ADDR;
+                ir.EmitRM("ST", AC, to_string(top + n), FP, "Call: Save Ret");
+                ir.EmitRM("ST", FP, to_string(top + n + 1), FP, "Call: Save FP");
+                ir.EmitRM("LDA", FP, to_string(top + n + 2), FP, "Call:Modify FP");
+                string name(inst.sym->token_ptr->Text());
+                calls[ir.EmitRM("LDC", PC, "?", "0", "Call: Jump To" + name)] = name;
+                def(inst.dst);
+                break;
+            }
+            case MInst::VEC:
+            {
+                // 操作数依次装入 AC1/BP/AR1，起始下标加到数组基址上，元素个数放在AC
+                auto b = BuiltIn::Find(inst.sym);
+                auto &ptype = inst.sym->GetPType();
+                int n = args.size();
+                int k = n - (b->offset ? 2 : 1);
+                const string regs[] = {AC1, BP, IR::AR1};
+                if (this->boundsCheck == IR::BOUNDS_FULL && !b->offset)
+                {
+                    // 元素个数不能超过数组头部记录的长度
+                    load(args[n - 1], AC);
+                    for (int j = 0; j < k; ++j)
+                    {
+                        if (ptype[j] == SymType::ARR)
+                        {
+                            load(args[j], AC1);
+                            ir.EmitRM("LD", AC1, "-1", AC1, "Load Arr Size");
+                            ir.EmitRO("SUB", AC1, AC1, AC);
+                            ir.EmitRM("JGE", AC1, "1", PC, "Check Element Count");
+                            ir.EmitRO("HALT", "-2", "0", "0", "Shutdown If Count Is Out Of Range");
+                        }
+                    }
+                }
+                for (int j = 0; j < k; ++j)
+                {
+                    load(args[j], regs[j]);
+                }
+                if (b->offset && !(isConst(args[n - 2], c) && c == 0))
+                {
+                    load(args[n - 2], AC);
+                    for (int j = 0; j < k; ++j)
+                    {
+                        if (ptype[j] == SymType::ARR)
+                        {
+                            ir.EmitRO("ADD", regs[j], regs[j], AC);
+                        }
+                    }
+                }
+                load(args[n - 1], AC);
+                vector<string> operands;
+                if (b->HasResult())
+                {
+                    operands.push_back(AC);
+                }
+                operands.insert(operands.end(), regs, regs + k);
+                operands.resize(3, "0");
+                ir.EmitRO(b->op, operands[0], operands[1], operands[2], "Builtin " + b->name);
+                if (b->HasResult())
+                {
+                    def(inst.dst);
+                }
+                break;
+            }
+            case MInst::IN:
+            {
+                ir.EmitRO("IN", AC, "0", "0");
+                def(inst.dst);
+                break;
+            }
+            case MInst::OUT:
+            {
+                load(args[0], AC);
+                ir.EmitRO("OUT", AC, "0", "0");
+                break;
+            }
+            case MInst::COPY:
+            {
+                // 并行复制的顺序化：目标不再被读取的复制先做，剩下的环借助临时位置打断
+                vector<std::pair<int, int>> pending;
+                for (size_t k = 0; k < args.size(); k += 2)
+                {
+                    if (slot[args[k]] != slot[args[k + 1]])
+                    {
+                        pending.push_back({args[k], args[k + 1]});
+                    }
+                }
+                int begin = ir.qps.size();
+                while (!pending.empty())
+                {
+                    bool done = false;
+                    for (size_t k = 0; k < pending.size() && !done; ++k)
+                    {
+                        int d = pending[k].first;
+                        bool read = false;
+                        for (auto &p : pending)
+                        {
+                            read = read || (p.second == d);
+                        }
+                        if (read)
+                        {
+                            continue;
+                        }
+                        int s = pending[k].second;
+                        if (s == -2)
+                        {
+                            ir.EmitRM("LD", AC, to_string(scratch), FP);
+                            acValue = -1;
+                        }
+                        else
+                        {
+                            load(s, AC);
+                        }
+                        ir.EmitRM("ST", AC, to_string(slot[d]), FP);
+                        pending.erase(pending.begin() + k);
+                        done = true;
+                    }
+                    if (!done)
+                    {
+                        int d = pending[0].first;
+                        load(d, AC);
+                        ir.EmitRM("ST", AC, to_string(scratch), FP);
+                        for (auto &p : pending)
+                        {
+                            p.second = (p.second == d) ? -2 : p.second;
+                        }
+                    }
+                }
+                if (begin != static_cast<int>(ir.qps.size()))
+                {
+                    ir.EmitComment("Phi Copy", begin);
+                }
+                acValue = -1;
+                break;
+            }
+            case MInst::BR:
+            {
+                int t = inst.blocks[0], e = inst.blocks[1];
+                TokenType relop = fused;
+                if (relop == TokenType::NONE)
+                {
+                    load(args[0], AC);
+                    relop = TokenType::NE;
+                }
+                if (e == next)
+                {
+                    jumps.push_back({ir.EmitRM(jop(relop, false), AC, "?", PC), t});
+                }
+                else if (t == next)
+                {
+                    jumps.push_back({ir.EmitRM(jop(relop, true), AC, "?", PC), e});
+                }
+                else
+                {
+                    jumps.push_back({ir.EmitRM(jop(relop, false), AC, "?", PC), t});
+                    jumps.push_back({ir.EmitRM("LDA", PC, "?", PC), e});
+                }
+                break;
+            }
+            case MInst::JMP:
+            {
+                if (inst.blocks[0] != next)
+                {
+                    jumps.push_back({ir.EmitRM("LDA", PC, "?", PC), inst.blocks[0]});
+                }
+                break;
+            }
+            case MInst::RET:
+            {
+                if (tail)
+                {
+                    tail = false;
+                    break;
+                }
+                if (!args.empty())
+                {
+                    load(args[0], AC);
+                }
+                ir.EmitRM("LDA", BP, "0", FP, "Ret: Save Current FP To BP");
+                ir.EmitRM("LD", FP, "-1", BP, "Restore FP");
+                ir.EmitRM("LD", PC, "-2", BP, "Ret");
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    for (auto &j : jumps)
+    {
+        ir.qps[j.first].addr2 = to_string(start.at(j.second) - j.first - 1);
+    }
+    ir.frameSize[f.name] = std::max(ir.frameTop, frame);
+    ir.EmitComment(" <- Ent " + f.name + " Frame " + to_string(ir.frameSize[f.name]), entry);
+    ir.inst_end[f.name] = ir.qps.size();
+}
+
+void MIR::PrintMIR()
+{
+    string str = this->ToString();
+    Logger::Print("%.*s", str.size(), str.data());
+}
+
+string MIR::ToString()
+{
+    static const char *names[] = {"?", "const", "add", "sub", "mul", "div", "cmp", "load", "store", "gload",
+                                  "gstore", "addr", "size", "call", "in", "out", "phi", "copy", "br", "jmp", "ret",
+                                  "shl", "shr", "loadp", "storep", "vec"};
+    string buffer;
+    buffer.reserve(1024 * 10);
+    buffer.append("-------------------------------------------\n");
+    buffer.append("SSA Mid-level IR:\n");
+    buffer.append("-------------------------------------------\n");
+    for (auto &f : funcs)
+    {
+        buffer.append(f.name).append(":\n");
+        for (auto &b : f.blocks)
+        {
+            if (!b.reachable)
+            {
+                continue;
+            }
+            buffer.append("B").append(to_string(b.id)).append(":");
+            if (!b.preds.empty())
+            {
+                buffer.append("  ; preds");
+                for (auto p : b.preds)
+                {
+                    buffer.append(" B").append(to_string(p));
+                }
+            }
+            buffer.append("\n");
+            for (auto *list : {&b.phis, &b.insts})
+            {
+                for (auto &inst : *list)
+                {
+                    buffer.append(MIR::INDENT, ' ');
+                    if (inst.dst >= 0)
+                    {
+                        buffer.append(f.isMem[inst.dst] ? "m" : "v").append(to_string(inst.dst)).append(" = ");
+                    }
+                    buffer.append(names[inst.op]);
+                    if (inst.op == MInst::CONST || inst.op == MInst::CMP || (inst.op >= MInst::SHL && inst.op <= MInst::STOREP))
+                    {
+                        buffer.append(" ").append(to_string(inst.imm));
+                    }
+                    if (inst.sym != nullptr)
+                    {
+                        buffer.append(" ").append(inst.sym->token_ptr->Text());
+                    }
+                    for (auto a : inst.args)
+                    {
+                        buffer.append(" ").append(f.isMem[a] ? "m" : "v").append(to_string(a));
+                    }
+                    if (inst.mem >= 0)
+                    {
+                        buffer.append(" [m").append(to_string(inst.mem)).append("]");
+                    }
+                    for (auto t : inst.blocks)
+                    {
+                        buffer.append(" B").append(to_string(t));
+                    }
+                    if (inst.mdst >= 0)
+                    {
+                        buffer.append(" -> m").append(to_string(inst.mdst));
+                    }
+                    buffer.append("\n");
+                }
+            }
+        }
+    }
+    buffer.append("-------------------------------------------\n");
+    return buffer;
+}
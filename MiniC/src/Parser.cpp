@@ -1,29 +1,32 @@
 #include "Parser.h"
+#include <algorithm>
 
 bool Parser::Parse(const char *filename)
 {
     this->filename = filename;
     Scanner scanner;
-    if (!scanner.Scan(this->filename))
-    {
-        return false;
-    }
-
-    return this->BuildAST();
+    scanner.Open(this->filename);
+    bool ok = this->Parse(scanner);
+    this->scanner = nullptr;
+    return ok && scanner.FLAG_SCANNER;
 }
 
 bool Parser::Parse(Scanner &scanner)
 {
-    this->tokenList = scanner.GetTokenList();
+    this->scanner = &scanner;
     return this->BuildAST();
 }
 
 bool Parser::BuildAST()
 {
-    if (this->tokenList.empty())
+    if (this->scanner == nullptr)
     {
         return false;
     }
+    this->listIdx = 0;
+    this->fetched = 0;
+    this->atEnd = false;
+    this->window.assign(WINDOW, Token(TokenType::NONE, "#"));
     Match(TokenType::NONE); // start of file
     this->tree.root = this->Program();
     Match(TokenType::NONE); // end of file
@@ -35,33 +38,52 @@ AST &Parser::GetAST()
     return this->tree;
 }
 
-Token &Parser::GetToken()
+const Token &Parser::Fetch(unsigned int idx)
+{
+    // 开始记号之后的第一个 NONE 是结束记号，之后不再扫描
+    while (this->fetched <= idx && !this->atEnd)
+    {
+        Token &slot = this->window[this->fetched % WINDOW];
+        slot = this->scanner->NextToken();
+        if (!this->scanner->FLAG_SCANNER)
+        {
+            // 与先扫描整个文件时一样，报告剩余的词法错误后结束，不再继续语法分析
+            while (!this->scanner->NextToken().IsTypeOf(TokenType::NONE))
+            {
+            }
+            exit(-1);
+        }
+        this->atEnd = (this->fetched > 0 && slot.IsTypeOf(TokenType::NONE));
+        this->fetched += 1;
+    }
+    return this->window[std::min(idx, this->fetched - 1) % WINDOW];
+}
+
+const Token &Parser::GetToken()
 {
-    auto idx = (this->listIdx < this->tokenList.size()) ? this->listIdx : (this->tokenList.size() - 1);
     this->listIdx += 1;
-    return this->tokenList.at(idx);
+    return this->Fetch(this->listIdx - 1);
 }
 
-Token &Parser::PrevToken(int prev)
+const Token &Parser::PrevToken(int prev)
 {
-    size_t idx = this->listIdx - prev - 1;
-    return this->tokenList.at(idx < 0 ? 0 : idx);
+    // 超出窗口时取窗口内最早的记号
+    prev = std::clamp(prev, 0, HISTORY);
+    unsigned int back = static_cast<unsigned int>(prev) + 1;
+    return this->Fetch(this->listIdx > back ? this->listIdx - back : 0);
 }
 
-Token &Parser::PeekToken(int peek)
+const Token &Parser::PeekToken(int peek)
 {
-    size_t idx = this->listIdx + peek - 1;
-    if (idx >= this->tokenList.size())
-    {
-        idx = this->tokenList.size() - 1;
-    }
-    return this->tokenList.at(idx);
+    // 超出窗口时取窗口内最后的记号
+    peek = std::clamp(peek, 1, LOOKAHEAD);
+    return this->Fetch(this->listIdx + peek - 1);
 }
 
 void Parser::Match(TokenType expect)
 {
 #if _DEBUG
-    Logger::Debug("%s ", this->curToken.val.c_str());
+    Logger::Debug("%.*s ", this->curToken.Text().size(), this->curToken.Text().data());
 #endif
 
     if (!this->curToken.IsTypeOf(expect))
@@ -72,10 +94,10 @@ void Parser::Match(TokenType expect)
     this->curToken = this->GetToken();
 }
 
-void Parser::EmitError(const string &error, Token &tk)
+void Parser::EmitError(const string &error, const Token &tk)
 {
     this->FLAG_AST = false;
-    const string &str = tk.val;
+    string_view str = tk.Text();
     Logger::Error("%.*s '%.*s' at (%d,%d)\n",
                   error.size(),
                   error.data(),
@@ -97,18 +119,12 @@ ASTNodePointer Parser::DeclList()
 {
     // declaration-list -> declaration-list declaration | declaration
     ASTNodePointer subTree = nullptr;
+    ASTNodePointer tail = nullptr;
 
     while (!this->curToken.IsTypeOf(TokenType::NONE))
     {
         ASTNodePointer ptr = Decl();
-        if (subTree == nullptr)
-        {
-            subTree = ptr;
-        }
-        else
-        {
-            subTree->AddSibling(ptr);
-        }
+        ASTNode::Append(subTree, tail, ptr);
     }
     return subTree;
 }
@@ -116,33 +132,14 @@ ASTNodePointer Parser::DeclList()
 ASTNodePointer Parser::Decl()
 {
     // declaration -> var-declaration | fun-declaration
-    //读入后续的Token，判断是变量声明还是函数声明
-
-    size_t size = this->tokenList.size() - this->listIdx;
-
-    for (size_t peek = 1; peek <= size; ++peek)
+    // 由 type ID 之后的记号判断：( 为函数声明，否则为变量声明(; 或 [)，
+    // 不合法的声明按变量声明分析并报告错误，每次至少消耗一个记号
+    const Token &next = this->PeekToken(2);
+    if (next.IsTypeOf(TokenType::LPAREN))
     {
-        Token token = this->PeekToken(peek);
-        switch (token.type)
-        {
-        case TokenType::LPAREN:
-        {
-            return this->FunDecl();
-        }
-        // case TokenType::ASSIGN:
-        case TokenType::SEMI:
-        {
-            return this->VarDecl();
-        }
-        case TokenType::NONE:
-        {
-            return nullptr;
-        }
-        default:
-            break;
-        }
+        return this->FunDecl();
     }
-    return nullptr;
+    return this->VarDecl();
 }
 
 ASTNodePointer Parser::VarDecl()
@@ -220,6 +217,7 @@ ASTNodePointer Parser::ParamList()
     // param->type - specifier ID | type - specifier ID[]
 
     ASTNodePointer subTree = nullptr;
+    ASTNodePointer tail = nullptr;
     while (!curToken.IsTypeOf(TokenType::RPAREN) && !curToken.IsTypeOf(TokenType::NONE))
     {
         Match(TokenType::INT);
@@ -232,14 +230,7 @@ ASTNodePointer Parser::ParamList()
             param->stmtType = StmtType::PARAM_ARR;
         }
 
-        if (subTree == nullptr)
-        {
-            subTree = param;
-        }
-        else
-        {
-            subTree->AddSibling(param);
-        }
+        ASTNode::Append(subTree, tail, param);
 
         if (curToken.IsTypeOf(TokenType::COMMA))
         {
@@ -289,18 +280,12 @@ ASTNodePointer Parser::LocalDecls()
 {
     // local-declarations -> local-declarations var-declaration | empty
     ASTNodePointer subTree = nullptr;
+    ASTNodePointer tail = nullptr;
     ASTNodePointer t = nullptr;
     while (curToken.IsTypeOf(TokenType::INT))
     {
         t = VarDecl();
-        if (subTree == nullptr)
-        {
-            subTree = t;
-        }
-        else
-        {
-            subTree->AddSibling(t);
-        }
+        ASTNode::Append(subTree, tail, t);
     }
     return subTree;
 }
@@ -310,18 +295,12 @@ ASTNodePointer Parser::StmtList()
     // statement-list ->statement-list statement | empty
     // return Stmt();
     ASTNodePointer subTree = nullptr;
+    ASTNodePointer tail = nullptr;
     ASTNodePointer ptr = nullptr;
-    while (!curToken.IsTypeOf(TokenType::RBRACE))
+    while (!curToken.IsTypeOf(TokenType::RBRACE) && !curToken.IsTypeOf(TokenType::NONE))
     {
         ptr = Stmt();
-        if (subTree == nullptr)
-        {
-            subTree = ptr;
-        }
-        else
-        {
-            subTree->AddSibling(ptr);
-        }
+        ASTNode::Append(subTree, tail, ptr);
     }
     return subTree;
 }
@@ -352,9 +331,16 @@ ASTNodePointer Parser::Stmt()
         this->EmitError("Unexpected Declaration", curToken);
         return nullptr;
     }
+    case TokenType::RBRACE:
+    case TokenType::NONE:
+        return nullptr;
     default:
+    {
+        // Error: 不能作为语句开头的记号，跳过
+        this->EmitError("Unexpected Token", curToken);
         return nullptr;
     }
+    }
 }
 
 ASTNodePointer Parser::ExpStmt()
@@ -495,7 +481,7 @@ ASTNodePointer Parser::Exp()
     // First(Exp)=ID ( NUM
     // Follow(Exp)= ; ) ] ,
     ASTNodePointer subTree = nullptr;
-    Token next = this->PeekToken();
+    const Token &next = this->PeekToken();
 
     switch (next.type)
     {
@@ -623,7 +609,7 @@ ASTNodePointer Parser::Factor()
     }
     case TokenType::ID:
     {
-        Token token = this->PeekToken();
+        const Token &token = this->PeekToken();
         if (token.IsTypeOf(TokenType::LPAREN))
         {
             subTree = Call();
@@ -657,17 +643,11 @@ ASTNodePointer Parser::Args()
     // args->arg - list | empty
     // arg - list->arg - list, expression | expression
     ASTNodePointer subTree = nullptr;
+    ASTNodePointer tail = nullptr;
     while (!curToken.IsTypeOf(TokenType::RPAREN) && !curToken.IsTypeOf(TokenType::NONE))
     {
         ASTNodePointer t = Exp();
-        if (subTree == nullptr)
-        {
-            subTree = t;
-        }
-        else
-        {
-            subTree->AddSibling(t);
-        }
+        ASTNode::Append(subTree, tail, t);
         if (!curToken.IsTypeOf(TokenType::RPAREN))
         {
             Match(TokenType::COMMA);
@@ -0,0 +1,175 @@
+#include "PassManager.h"
+#include "MCLog.h"
+#include <chrono>
+
+PassManager::PassManager()
+{
+    this->passes = {
+        {"frame", O1, "Overlap Locals Of Disjoint Scopes In The Stack Frame"},
+        {"const-eval", O1, "Evaluate Input-free Programs And Constant Calls At Compile Time"},
+        {"bounds-elim", O1, "Remove Array Bounds Checks Proven Safe"},
+        {"vectorize", O1, "Lower Element-wise And Reduction Array Loops To Vector Instructions"},
+        {"unroll", O1, "Unroll Counted Loops, Fully When The Trip Count Is Small"},
+        {"inline", O1, "Inline Small Functions"},
+        {"licm", O1, "Hoist Loop Invariant Expressions"},
+        {"tail-call", O1, "Reuse The Frame For Calls In Return Position"},
+        {"ssa", O2, "Generate Code Through SSA Mid-level IR With Value Numbering"},
+        {"jump-thread", O1, "Thread Jumps To Their Final Destination And Invert Branches Over Jumps"},
+        {"dce", O1, "Remove Unreachable Code And Uncalled Functions"},
+        {"liveness", O1, "Remove Dead Stores And Unused Results"},
+    };
+}
+
+PassInfo *PassManager::Find(const string &name)
+{
+    for (auto &p : this->passes)
+    {
+        if (p.name == name)
+        {
+            return &p;
+        }
+    }
+    return nullptr;
+}
+
+bool PassManager::SetLevel(int level)
+{
+    if (level < O0 || level > O2)
+    {
+        return false;
+    }
+    this->level = level;
+    return true;
+}
+
+bool PassManager::Set(const string &name, bool on)
+{
+    auto p = this->Find(name);
+    if (p == nullptr)
+    {
+        return false;
+    }
+    p->state = on ? 1 : 0;
+    return true;
+}
+
+bool PassManager::Enabled(const string &name)
+{
+    auto p = this->Find(name);
+    if (p == nullptr)
+    {
+        return false;
+    }
+    return (p->state < 0) ? (this->level >= p->level) : (p->state == 1);
+}
+
+void PassManager::Time(const string &name, const function<void()> &body, const function<PassSize()> &measure)
+{
+    if (!this->timePasses)
+    {
+        body();
+        return;
+    }
+    PassStat stat;
+    stat.name = name;
+    stat.before = measure();
+    auto start = std::chrono::steady_clock::now();
+    body();
+    auto stop = std::chrono::steady_clock::now();
+    stat.ms = std::chrono::duration<double, std::milli>(stop - start).count();
+    stat.after = measure();
+    this->stats.push_back(stat);
+}
+
+bool PassManager::Run(const string &name, const function<void()> &body, const function<PassSize()> &measure)
+{
+    if (!this->Enabled(name))
+    {
+        return false;
+    }
+    this->Time(name, body, measure);
+    return true;
+}
+
+void PassManager::PrintTimes()
+{
+    if (!this->timePasses)
+    {
+        return;
+    }
+    double total = 0;
+    Logger::Print("# Pass Timing (-O%d)\n", this->level);
+    Logger::Print("%-14s %10s %10s %10s %10s\n", "Pass", "Time(ms)", "Before", "After", "Mem(KB)");
+    for (auto &s : this->stats)
+    {
+        total += s.ms;
+        Logger::Print("%-14s %10.3f %10lld %10lld %10.1f\n", s.name.c_str(), s.ms, s.before.units, s.after.units,
+                      s.after.bytes / 1024.0);
+    }
+    Logger::Print("%-14s %10.3f\n", "Total", total);
+}
+
+string PassManager::Usage()
+{
+    string buffer;
+    for (auto &p : this->passes)
+    {
+        buffer.append("--").append(p.name).append("=0|1: ").append(p.desc);
+        buffer.append(" (-O").append(to_string(p.level)).append(")\n");
+    }
+    return buffer;
+}
+
+PassSize PassManager::Measure(Scanner &scanner)
+{
+    auto &tokens = scanner.GetTokenList();
+    PassSize size;
+    size.units = scanner.TokenCount();
+    // 边扫描边分析时不保存记号列表；记号名称保存在全局字符串表中，不计入
+    size.bytes = tokens.capacity() * sizeof(Token);
+    return size;
+}
+
+long long PassManager::CountNodes(ASTNodePointer subTree)
+{
+    long long n = 0;
+    for (auto ptr = subTree; ptr != nullptr; ptr = ptr->sibling)
+    {
+        ++n;
+        for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+        {
+            n += CountNodes(ptr->child[i]);
+        }
+    }
+    return n;
+}
+
+PassSize PassManager::Measure(AST &ast)
+{
+    PassSize size;
+    size.units = CountNodes(ast.root);
+    size.bytes = size.units * sizeof(ASTNode);
+    return size;
+}
+
+PassSize PassManager::Measure(MIR &mir)
+{
+    PassSize size;
+    for (auto &f : mir.funcs)
+    {
+        for (auto &b : f.blocks)
+        {
+            size.units += b.phis.size() + b.insts.size();
+            size.bytes += (b.phis.capacity() + b.insts.capacity()) * sizeof(MInst);
+        }
+    }
+    return size;
+}
+
+PassSize PassManager::Measure(IR &ir)
+{
+    PassSize size;
+    size.units = ir.qps.size();
+    size.bytes = ir.qps.capacity() * sizeof(Quadruple);
+    return size;
+}
@@ -1,30 +1,25 @@
 #include "Scanner.h"
 #include "MCLog.h"
+#include <algorithm>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
-Scanner::Scanner()
+bool Scanner::Open(const string &filename)
 {
-    this->buffer = new char[this->bufferSize];
-    memset(&buffer[0], 0, this->bufferSize);
-}
-
-Scanner::~Scanner()
-{
-    if (this->buffer != nullptr)
+    if (!this->Load(filename))
     {
-        delete[] this->buffer;
-        this->buffer = nullptr;
+        Logger::Error("Can Not Open File \"%s\"\n", filename.c_str());
+        exit(-1);
     }
-    ifs.close();
+    this->tokenList.clear();
+    this->next = 0;
+    return true;
 }
 
 bool Scanner::Scan(const string &filename)
 {
-    this->ifs.open(filename);
-    if (!(this->ifs.is_open()))
-    {
-        Logger::Error("Can Not Open File \"%s\"\n", filename.c_str());
-        exit(-1);
-    }
+    this->Open(filename);
     Token t{TokenType::NONE, "SOF"};
     tokenList.push_back(t);
     do
@@ -36,95 +31,117 @@ bool Scanner::Scan(const string &filename)
     return this->FLAG_SCANNER;
 }
 
-bool Scanner::FillBuffer()
+Token Scanner::NextToken()
 {
-    if (!ifs.eof())
+    // Scan 已保存整个列表时依次取出，否则边扫描边返回
+    if (this->next < this->tokenList.size())
+    {
+        return this->tokenList[this->next++];
+    }
+    if (this->next++ == 0)
     {
-        this->linePos = 0;
-        this->ifs.read(&(this->buffer[0]), this->bufferSize);
-        this->lineLen = static_cast<int>(this->ifs.gcount());
-        return true;
+        return Token(TokenType::NONE, "SOF");
     }
-    return false;
+    // 没有读入源文件时视为空文件
+    return (this->cur == nullptr) ? Token(TokenType::NONE, "EOF") : this->GetToken();
 }
 
-char Scanner::GetNextChar()
+size_t Scanner::TokenCount() const
 {
-    if (this->linePos >= this->lineLen && !(this->FillBuffer()))
-    {
-        return 0;
-    }
-    char c = buffer[linePos++];
-    if (c == '\n')
+    return std::max(this->tokenList.size(), this->next);
+}
+
+bool Scanner::Load(const string &filename)
+{
+    // 按二进制读入，行号只由 '\n' 决定，'\r' 作为空白字符跳过
+    ifstream ifs(filename, std::ios::in | std::ios::binary);
+    if (!ifs.is_open())
     {
-        this->row += 1;
-        this->col = 0;
+        return false;
     }
-    else
+    ifs.seekg(0, std::ios::end);
+    auto size = ifs.tellg();
+    ifs.seekg(0, std::ios::beg);
+    this->source.assign(size > 0 ? static_cast<size_t>(size) : 0, '\0');
+    ifs.read(&this->source[0], this->source.size());
+    this->source.resize(static_cast<size_t>(ifs.gcount()));
+    // 与逐字符读取时一样，'\0' 之后的内容不再扫描
+    this->source.resize(strlen(this->source.c_str()));
+
+    this->cur = this->source.c_str();
+    this->end = this->cur + this->source.size();
+    this->lineStart.assign(1, 0);
+    for (auto p = static_cast<const char *>(memchr(this->cur, '\n', this->source.size())); p != nullptr;
+         p = static_cast<const char *>(memchr(p + 1, '\n', this->end - p - 1)))
     {
-        this->col += 1;
+        this->lineStart.push_back(p + 1 - this->cur);
     }
-
-    return c;
+    return true;
 }
 
-void Scanner::PutBackChar()
+void Scanner::Locate(size_t offset, int &row, int &col)
 {
-    if (this->linePos > 0)
+    // 记号按偏移递增的顺序生成，从上次所在的行向后查找，整体是线性的
+    auto &line = this->lastLine;
+    if (line >= this->lineStart.size() || this->lineStart[line] > offset)
     {
-        // 缓冲区指针退回上个字符
-        this->linePos -= 1;
+        line = std::upper_bound(this->lineStart.begin(), this->lineStart.end(), offset) - this->lineStart.begin() - 1;
     }
-    if (this->buffer[this->linePos] == '\n')
+    while (line + 1 < this->lineStart.size() && this->lineStart[line + 1] <= offset)
     {
-        // 退回上一行
-        this->row -= 1;
+        line += 1;
     }
-    else if (this->col > 0)
+    row = static_cast<int>(line) + 1;
+    col = static_cast<int>(offset - this->lineStart[line]) + 1;
+}
+
+char Scanner::GetNextChar()
+{
+    // 读到末尾的 '\0' 时也前进一个字符，保证之后可以回退
+    if (this->cur > this->end)
     {
-        // 退回前一列
-        this->col -= 1;
+        return 0;
     }
+    return *this->cur++;
+}
+
+void Scanner::PutBackChar()
+{
+    this->cur -= 1;
 }
 
 Token Scanner::GetToken()
 {
     StateType state = StateType::START;
-    Token token;
+    TokenType type = TokenType::NONE;
+    int row = 0, col = 0;
+    const char *first = this->cur; // 记号的首字符，记号的内容为 [first, cur)
     while (state != StateType::DONE)
     {
         char nChar = GetNextChar();
-        bool save = true;
 
         switch (state)
         {
         case StateType::START:
         {
-            token.row = this->row;
-            token.col = this->col;
+            first = this->cur - 1;
 
             if (nChar < 0 || nChar > 255)
             {
                 state = StateType::ERROR;
-                nChar &= 255;
-                if (!ifs.eof() && ifs.fail())
-                    ifs.clear();
                 this->PutBackChar();
             }
-            else if (isalpha(nChar))
+            else if (isalpha(nChar) || isdigit(nChar))
             {
-                state = StateType::INID;
-                token.type = TokenType::ID;
-            }
-            else if (isdigit(nChar))
-            {
-                state = StateType::INNUM;
-                token.type = TokenType::NUM;
+                // 标识符只含字母，常数只含数字，整段取出
+                bool id = isalpha(nChar);
+                this->cur = id ? SpanAlpha(this->cur, this->end) : SpanDigit(this->cur, this->end);
+                type = id ? TokenType::ID : TokenType::NUM;
+                state = StateType::DONE;
             }
             else if (isspace(nChar))
             {
-                save = false;
-                break;
+                this->cur = SkipSpace(this->cur, this->end);
             }
             else
             {
@@ -133,94 +150,212 @@ Token Scanner::GetToken()
                     return Token(TokenType::NONE, "EOF");
                 }
                 state = StateType::MORE;
-                token.type = Token::GetSymbolType(string(1, nChar));
+                type = Token::GetSymbolType(string_view(first, 1));
             }
             break;
         }
         case StateType::INCOMMENT:
         {
-            save = false;
-            if (nChar == '*')
-            {
-                nChar = GetNextChar();
-                if (nChar == '/')
-                    state = StateType::START;
-            }
-            break;
-        }
-        case StateType::INID:
-        {
-            if (!isalpha(nChar)) // !(isalpha(nChar) || isdigit(nChar))
+            if (nChar == 0)
             {
-                save = false;
-                PutBackChar();
-                state = StateType::DONE;
+                Logger::Error("Unterminated Comment (row: %d col: %d )\n", row, col);
+                this->FLAG_SCANNER = false;
+                return Token(TokenType::NONE, "EOF");
             }
-            break;
-        }
-        case StateType::INNUM:
-        {
-            if (!isdigit(nChar))
+            if (nChar == '*' && *this->cur == '/')
             {
-                save = false;
-                PutBackChar();
-                state = StateType::DONE;
+                this->cur += 1;
+                state = StateType::START;
+                break;
             }
+            this->cur = FindCommentEnd(this->cur, this->end);
             break;
         }
         case StateType::MORE:
         {
             state = StateType::DONE;
-            if (nChar == 0)
-            {
-                break;
-            }
-            if (token.type == TokenType::DIVISION && nChar == '*')
+            if (type == TokenType::DIVISION && nChar == '*')
             {
                 // 注释 /*
-                token.val.clear();
+                this->Locate(first - this->source.c_str(), row, col);
+                this->cur = FindCommentEnd(this->cur, this->end);
                 state = StateType::INCOMMENT;
+                break;
             }
-            else if (Token::IsNeedMore(token.val[0]) && nChar == '=')
-            { 
+            if (Token::IsNeedMore(*first) && nChar == '=')
+            {
                 // 比较运算符
-                TokenType t = Token::GetSymbolType(token.val + nChar);
+                TokenType t = Token::GetSymbolType(string_view(first, 2));
                 if (t != TokenType::INVALID)
                 {
-                    token.type = t;
+                    type = t;
                     break;
                 }
             }
-            save = false;
             this->PutBackChar();
             break;
         }
         case StateType::ERROR:
         {
-            Logger::Error("Invalid Character: %c (row: %d col: %d )\n", nChar, token.row, token.col);
+            this->Locate(first - this->source.c_str(), row, col);
+            Logger::Error("Invalid Character: %c (row: %d col: %d )\n", nChar, row, col);
             state = StateType::DONE;
-            token.type = TokenType::INVALID;
+            type = TokenType::INVALID;
             break;
         }
         default:
             break;
         }
-        if (save)
-            token.val.push_back(nChar);
     }
 
+    if (type == TokenType::ID)
+    {
+        type = Token::GetKeywordType(string_view(first, this->cur - first));
+    }
+    Token token(type, string_view(first, this->cur - first));
+    this->Locate(first - this->source.c_str(), token.row, token.col);
     if (token.IsTypeOf(TokenType::INVALID))
     {
-        Logger::Error("Invalid Token: %s (row: %d col: %d )\n", token.val.c_str(), token.row, token.col);
+        Logger::Error("Invalid Token: %.*s (row: %d col: %d )\n", static_cast<int>(token.Text().size()), token.Text().data(),
+                      token.row, token.col);
         this->FLAG_SCANNER = false;
     }
+    return token;
+}
 
-    if (token.IsTypeOf(TokenType::ID))
+const char *Scanner::SkipSpace(const char *p, const char *end)
+{
+#if defined(__AVX2__)
+    for (; p + 32 <= end; p += 32)
+    {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i ctrl = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('\t' - 1)),
+                                        _mm256_cmpgt_epi8(_mm256_set1_epi8('\r' + 1), c));
+        __m256i space = _mm256_or_si256(ctrl, _mm256_cmpeq_epi8(c, _mm256_set1_epi8(' ')));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(space));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    for (; p + 16 <= end; p += 16)
+    {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i ctrl = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('\t' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('\r' + 1)));
+        __m128i space = _mm_or_si128(ctrl, _mm_cmpeq_epi8(c, _mm_set1_epi8(' ')));
+        unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(space)) & 0xFFFF;
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (p < end && isspace(static_cast<unsigned char>(*p)))
     {
-        token.type = Token::GetKeywordType(token.val);
+        ++p;
     }
+    return p;
+}
 
-    return token;
+const char *Scanner::SpanAlpha(const char *p, const char *end)
+{
+#if defined(__AVX2__)
+    for (; p + 32 <= end; p += 32)
+    {
+        // 转为小写后落在 a-z 内；最高位为1的字节按有符号比较不在范围内
+        __m256i c = _mm256_or_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), _mm256_set1_epi8(0x20));
+        __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('a' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), c));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(alpha));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    for (; p + 16 <= end; p += 16)
+    {
+        __m128i c = _mm_or_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), _mm_set1_epi8(0x20));
+        __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('z' + 1)));
+        unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(alpha)) & 0xFFFF;
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (p < end && isalpha(static_cast<unsigned char>(*p)))
+    {
+        ++p;
+    }
+    return p;
+}
+
+const char *Scanner::SpanDigit(const char *p, const char *end)
+{
+#if defined(__AVX2__)
+    for (; p + 32 <= end; p += 32)
+    {
+        __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(c, _mm256_set1_epi8('0' - 1)),
+                                         _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), c));
+        unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(digit));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    for (; p + 16 <= end; p += 16)
+    {
+        __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(c, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(c, _mm_set1_epi8('9' + 1)));
+        unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(digit)) & 0xFFFF;
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (p < end && isdigit(static_cast<unsigned char>(*p)))
+    {
+        ++p;
+    }
+    return p;
+}
+
+const char *Scanner::FindCommentEnd(const char *p, const char *end)
+{
+    // 比较 p[i] == '*' 与 p[i+1] == '/'，第二次读取最多到末尾的 '\0'
+#if defined(__AVX2__)
+    for (; p + 32 <= end; p += 32)
+    {
+        __m256i star = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), _mm256_set1_epi8('*'));
+        __m256i slash = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 1)), _mm256_set1_epi8('/'));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(star, slash)));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    for (; p + 16 <= end; p += 16)
+    {
+        __m128i star = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), _mm_set1_epi8('*'));
+        __m128i slash = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 1)), _mm_set1_epi8('/'));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(star, slash)));
+        if (mask != 0)
+        {
+            return p + __builtin_ctz(mask);
+        }
+    }
+#endif
+    while (p < end && !(p[0] == '*' && p[1] == '/'))
+    {
+        ++p;
+    }
+    return p;
 }
 
 vector<Token> &Scanner::GetTokenList()
@@ -252,7 +387,7 @@ string Scanner::ToString()
             .append(": ")
             .append(token.GetTypeName())
             .append(": '")
-            .append(token.val)
+            .append(token.Text())
             .append("'\n");
     }
     return str;
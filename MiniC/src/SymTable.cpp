@@ -1,25 +1,36 @@
 #include "SymTable.h"
+#include "BuiltIn.h"
 #include <stack>
 using std::stack;
 
+void *SymNode::operator new(size_t size)
+{
+    // ptype 需要析构，内存池释放时调用
+    return Arena::Current().Alloc(size, alignof(SymNode), [](void *ptr) { static_cast<SymNode *>(ptr)->~SymNode(); });
+}
+
+void SymNode::operator delete(void *)
+{
+}
+
 bool SymNode::IsVar()
 {
-    return (!this->tag.empty()) && (this->tag[0] == 'V');
+    return this->kind == SymKind::VAR;
 }
 
 bool SymNode::IsArr()
 {
-    return (!this->tag.empty()) && (this->tag[0] == 'A');
+    return this->kind == SymKind::ARR;
 }
 
 bool SymNode::IsFunc()
 {
-    return (!this->tag.empty()) && (this->tag[0] == 'F');
+    return this->kind == SymKind::FUNC;
 }
 
 bool SymNode::IsBlock()
 {
-    return (!this->tag.empty()) && (this->tag[0] == 'B');
+    return this->kind == SymKind::BLOCK;
 }
 
 bool SymNode::HasScope()
@@ -29,17 +40,17 @@ bool SymNode::HasScope()
 
 bool SymNode::IsGlobal()
 {
-    return (this->prev != nullptr && this->prev->tag == "_global");
+    return this->storage == Storage::GLOBAL;
 }
 
 bool SymNode::IsParam()
 {
-    return (this->tag.size() > 3 && this->tag[2] == 'P');
+    return this->storage == Storage::PARAM;
 }
 
 bool SymNode::IsLocal()
 {
-    return (this->tag.size() > 3 && this->tag[2] == 'L');
+    return this->storage == Storage::LOCAL;
 }
 
 void SymNode::Insert(SymNodePointer node)
@@ -64,26 +75,57 @@ int SymNode::Allocate(size_t size)
     return this->prev->Allocate(size);
 }
 
-string_view SymNode::GetRType()
+SymType SymNode::GetRType()
 {
-    string_view sv = this->tag;
-    size_t pos = sv.find_last_of(":");
-    if (pos == string_view::npos)
-    {
-        return "?";
-    }
-    return sv.substr(pos - 1, 1);
+    return this->rtype;
+}
+
+const vector<SymType> &SymNode::GetPType()
+{
+    return this->ptype;
+}
+
+int SymNode::GetArrSize()
+{
+    return this->IsArr() ? this->length : -1;
 }
 
-string_view SymNode::GetPType()
+string SymNode::Tag()
 {
-    string_view sv = this->tag;
-    size_t pos = sv.find_last_of(":");
-    if (pos == string_view::npos)
+    static const char KIND[] = {'_', 'B', 'V', 'A', 'F'};
+    static const char STORAGE[] = {'_', 'G', 'P', 'L'};
+    if (this->kind == SymKind::SCOPE)
     {
-        return "?";
+        return "_global";
     }
-    return sv.substr(pos + 1);
+    if (this->kind == SymKind::BLOCK)
+    {
+        return "B:_:_:_";
+    }
+    string tag;
+    tag.push_back(KIND[static_cast<int>(this->kind)]);
+    tag.push_back(':');
+    tag.push_back(STORAGE[static_cast<int>(this->storage)]);
+    tag.push_back(':');
+    tag.append(this->token_ptr->Text()).push_back(':');
+    if (this->kind == SymKind::FUNC)
+    {
+        tag.push_back(static_cast<char>(this->rtype));
+        tag.push_back(':');
+        for (auto t : this->ptype)
+        {
+            tag.push_back(static_cast<char>(t));
+        }
+    }
+    else if (this->length < 0)
+    {
+        tag.push_back('#');
+    }
+    else
+    {
+        tag.append(std::to_string(this->length));
+    }
+    return tag;
 }
 
 SymNodePointer SymNode::GetFP()
@@ -95,12 +137,6 @@ SymNodePointer SymNode::GetFP()
     return (this->prev == nullptr) ? nullptr : this->prev->GetFP();
 }
 
-SymTable::~SymTable()
-{
-    this->Destroy(this->symtab);
-    this->symtab = nullptr;
-}
-
 void SymTable::PrintTable()
 {
     string buffer;
@@ -146,29 +182,6 @@ string SymTable::ToString()
     return buffer;
 }
 
-void SymTable::Destroy(SymNodePointer node)
-{
-    if (node == nullptr)
-    {
-        return;
-    }
-    SymNodePointer guard = node->prev;
-    SymNodePointer tmp = nullptr;
-    while (node != nullptr && node != guard)
-    {
-        if (node->HasScope())
-        {
-            this->Destroy(node->scope);
-        }
-        tmp = node;
-        node = node->next;
-#if _DEBUG
-        Logger::Debug("%s\n", tmp->tag.c_str());
-#endif
-        delete tmp;
-    }
-}
-
 void SymTable::PrintTable(SymNodePointer subTable, string &buffer, int indent)
 {
     stack<SymNodePointer> s;
@@ -186,8 +199,8 @@ void SymTable::PrintTable(SymNodePointer subTable, string &buffer, int indent)
         {
             buffer.append(indent, ' ');
             buffer.append("|---");
-            buffer.append(ptr->token_ptr->val).append(", ");
-            buffer.append(ptr->tag).append(", ");
+            buffer.append(ptr->token_ptr->Text()).append(", ");
+            buffer.append(ptr->Tag()).append(", ");
             buffer.append(std::to_string(ptr->memloc));
             buffer.append("\n");
         }
@@ -205,10 +218,23 @@ void SymTable::PrintTable(SymNodePointer subTable, string &buffer, int indent)
 
 void SymTable::PrintReference(ASTNodePointer subTree, string &buffer, int indent)
 {
-    if (subTree == nullptr)
+    // 先序遍历，用显式栈代替递归；兄弟结点先入栈，在子结点之后打印
+    vector<pair<ASTNodePointer, int>> stack{{subTree, indent}};
+    while (!stack.empty())
     {
-        return;
+        subTree = stack.back().first;
+        indent = stack.back().second;
+        stack.pop_back();
+        if (subTree == nullptr)
+        {
+            continue;
+        }
+        this->PrintReference(subTree, buffer, indent, stack);
     }
+}
+
+void SymTable::PrintReference(ASTNodePointer subTree, string &buffer, int indent, vector<pair<ASTNodePointer, int>> &stack)
+{
     auto s_child = subTree->child;
     switch (subTree->stmtType)
     {
@@ -217,13 +243,13 @@ void SymTable::PrintReference(ASTNodePointer subTree, string &buffer, int indent
     case StmtType::FUNC_CALL:
     {
         buffer.append(indent, ' ').append("|---");
-        buffer.append(subTree->token.val)
+        buffer.append(subTree->token.Text())
             .append(" (")
             .append(std::to_string(subTree->token.row))
             .append(",")
             .append(std::to_string(subTree->token.col))
             .append(") -> ")
-            .append(subTree->symbol_ptr->tag)
+            .append(subTree->symbol_ptr->Tag())
             .append(" (")
             .append(std::to_string(subTree->symbol_ptr->token_ptr->row))
             .append(",")
@@ -234,7 +260,7 @@ void SymTable::PrintReference(ASTNodePointer subTree, string &buffer, int indent
     case StmtType::FUNC_DECL:
     {
         buffer.append(indent, ' ').append("|---");
-        buffer.append(subTree->token.val);
+        buffer.append(subTree->token.Text());
         if (subTree->symbol_ptr->HasScope())
         {
             buffer.append(":\n");
@@ -249,40 +275,64 @@ void SymTable::PrintReference(ASTNodePointer subTree, string &buffer, int indent
         break;
     }
 
-    for (auto i = 0; i < ASTNode::MAXCHILD; ++i)
+    stack.emplace_back(subTree->sibling, indent);
+    for (auto i = ASTNode::MAXCHILD - 1; i >= 0; --i)
     {
-        this->PrintReference(s_child[i], buffer, SymTable::INDENT);
+        stack.emplace_back(s_child[i], SymTable::INDENT);
     }
-    this->PrintReference(subTree->sibling, buffer, indent);
 }
 
-SymNodePointer SymTable::LookUp(const string &tname, SymNodePointer node)
+SymNodePointer SymTable::LookUp(int id)
+{
+    return (id >= 0 && static_cast<size_t>(id) < this->visible.size()) ? this->visible[id] : nullptr;
+}
+
+SymNodePointer SymTable::LookUpGlobal(int id)
 {
-    if (node == nullptr)
+    auto ptr = this->LookUp(id);
+    while (ptr != nullptr && ptr->prev != this->symtab)
     {
-        return nullptr;
+        ptr = ptr->shadow;
     }
-    TokenPointer tp = nullptr;
-    for (auto ptr = node->scope; ptr != nullptr; ptr = ptr->next)
+    return ptr;
+}
+
+void SymTable::Bind(SymNodePointer symbol)
+{
+    int id = symbol->token_ptr->id;
+    if (static_cast<size_t>(id) >= this->visible.size())
     {
-        tp = ptr->token_ptr;
-        if (tp && tp->val == tname)
-        {
-            return ptr;
-        }
+        this->visible.resize(id + 1, nullptr);
     }
-    return nullptr;
+    symbol->shadow = this->visible[id];
+    this->visible[id] = symbol;
+    this->bound.push_back(symbol);
 }
 
-bool SymTable::Build(AST &ast)
+void SymTable::PushScope()
 {
-    this->root = ast.root;
+    this->scopes.push_back(this->bound.size());
+}
 
-    if (this->symtab)
+void SymTable::PopScope()
+{
+    size_t mark = this->scopes.back();
+    this->scopes.pop_back();
+    while (this->bound.size() > mark)
     {
-        this->Destroy(this->symtab);
+        auto symbol = this->bound.back();
+        this->visible[symbol->token_ptr->id] = symbol->shadow;
+        this->bound.pop_back();
     }
-    this->symtab = new SymNode("_global");
+}
+
+bool SymTable::Build(AST &ast)
+{
+    this->root = ast.root;
+    this->visible.clear();
+    this->bound.clear();
+    this->scopes.clear();
+    this->symtab = new SymNode();
     this->InitBuiltIn();
     this->Build(this->root, this->symtab);
     return this->FLAG_SYMTAB;
@@ -318,23 +368,21 @@ void SymTable::Build(ASTNodePointer ast, SymNodePointer node)
         }
         case StmtType::COMP_STMT:
         {
-            SymNodePointer block = new SymNode("B:_:_:_");
+            SymNodePointer block = new SymNode(SymKind::BLOCK);
             block->token_ptr = &(ptr->token);
             block->prev = node;
             block->next = (node->scope == nullptr) ? node : node->scope;
             block->scope = block; // 连接到外部作用域
+            this->PushScope();
             for (auto i = 0; i < ASTNode::MAXCHILD; ++i)
             {
                 this->Build(ptr->child[i], block);
             }
+            this->PopScope();
             if (block->HasScope())
             {
                 node->Insert(block);
             }
-            else
-            {
-                delete block;
-            }
 
             break;
         }
@@ -342,7 +390,7 @@ void SymTable::Build(ASTNodePointer ast, SymNodePointer node)
         case StmtType::VAR_CALL:
         case StmtType::ARR_CALL:
         {
-            auto symbol = this->LookUp(ptr->token.val, node);
+            auto symbol = this->LookUp(ptr->token.id);
             if (symbol == nullptr)
             {
                 // Error: 未定义符号
@@ -354,15 +402,15 @@ void SymTable::Build(ASTNodePointer ast, SymNodePointer node)
         }
         case StmtType::FUNC_CALL:
         {
-            const string &name = ptr->token.val;
+            string_view name = ptr->token.Text();
             SymNodePointer symbol = nullptr;
             if (name == "input" || name == "output")
             {
-                symbol = this->LookUp(name, this->symtab);
+                symbol = this->LookUpGlobal(ptr->token.id);
             }
             else
             {
-                symbol = this->LookUp(name, node);
+                symbol = this->LookUp(ptr->token.id);
             }
 
             if (symbol == nullptr)
@@ -401,31 +449,31 @@ void SymTable::AddVar(ASTNodePointer subTree, SymNodePointer node, int pn)
     }
     SymNodePointer symbol = nullptr;
     TokenPointer token = &(subTree->token);
-    symbol = this->LookUp(token->val, node); // 检查符号是否已经存在
+    symbol = this->LookUp(token->id); // 检查符号是否已经存在
     if (symbol != nullptr && symbol == nullptr)
     {
         // Error: 重定义
         this->EmitSymError("Duplicate Definition", subTree->token);
         return;
     }
-    symbol = new SymNode();
+    symbol = new SymNode(SymKind::VAR);
     symbol->token_ptr = token;
     if (node == this->symtab)
     {
-        symbol->tag.append("V:G:"); // 全局变量
+        symbol->storage = Storage::GLOBAL; // 全局变量
     }
     else if (subTree->IsTypeOf(StmtType::PARAM_ARR))
     {
-        symbol->tag.append("V:P:"); // 参数
+        symbol->storage = Storage::PARAM; // 参数
     }
     else
     {
-        symbol->tag.append("V:L:"); // 局部变量
+        symbol->storage = Storage::LOCAL; // 局部变量
     }
-    symbol->tag.append(token->val);
-    symbol->tag.append(":1");
     symbol->memloc = (pn >= 0) ? node->Allocate(1) : pn;
     node->Insert(symbol);
+    this->Bind(symbol);
+    subTree->symbol_ptr = symbol;
 }
 
 void SymTable::AddArr(ASTNodePointer subTree, SymNodePointer node, int pn)
@@ -436,7 +484,7 @@ void SymTable::AddArr(ASTNodePointer subTree, SymNodePointer node, int pn)
     }
     SymNodePointer symbol = nullptr;
     TokenPointer token = &(subTree->token);
-    symbol = this->LookUp(token->val, node); // 检查符号是否已经存在
+    symbol = this->LookUp(token->id); // 检查符号是否已经存在
     if (symbol != nullptr && symbol == nullptr)
     {
         // Error: 重定义
@@ -444,33 +492,41 @@ void SymTable::AddArr(ASTNodePointer subTree, SymNodePointer node, int pn)
         return;
     }
 
-    symbol = new SymNode();
+    symbol = new SymNode(SymKind::ARR);
     // 数组长度
     size_t length = 1;
     auto sc = subTree->child;
     if (subTree->IsTypeOf(StmtType::ARR_DECL))
     {
         // 数组声明，分配实际大小
-        length = std::stoi(sc[0]->token.val);
-        if (node == this->symtab)
-        {
-            symbol->tag.append("A:G:"); // 全局
-        }
-        else
-        {
-            symbol->tag.append("A:L:"); // 局部
-        }
-        symbol->tag.append(token->val).append(":").append(sc[0]->token.val);
+        length = std::stoi(string(sc[0]->token.Text()));
+        symbol->length = length;
+        symbol->storage = (node == this->symtab) ? Storage::GLOBAL : Storage::LOCAL;
     }
     else
     {
         //函数数组形参，分配一个空间占位
-        symbol->tag.append("A:P:").append(token->val).append(":#");
+        symbol->length = -1;
+        symbol->storage = Storage::PARAM;
     }
 
     symbol->token_ptr = token;
-    symbol->memloc = (pn >= 0) ? node->Allocate(length) : pn;
+    if (pn < 0)
+    {
+        symbol->memloc = pn;
+    }
+    else if (this->arrayHeader)
+    {
+        // 长度保存在数组首元素之前
+        symbol->memloc = node->Allocate(length + 1) + 1;
+    }
+    else
+    {
+        symbol->memloc = node->Allocate(length);
+    }
     node->Insert(symbol);
+    this->Bind(symbol);
+    subTree->symbol_ptr = symbol;
 }
 
 void SymTable::AddFunc(ASTNodePointer subTree)
@@ -481,24 +537,25 @@ void SymTable::AddFunc(ASTNodePointer subTree)
     }
     SymNodePointer symbol = nullptr;
     TokenPointer token = &(subTree->token);
-    symbol = this->LookUp(token->val, this->symtab); // 检查符号是否已经存在
+    symbol = this->LookUpGlobal(token->id); // 检查符号是否已经存在
     if (symbol != nullptr)
     {
         // Error: 重定义
         this->EmitSymError("Duplicate Definition", subTree->token);
         return;
     }
-    symbol = new SymNode();
+    symbol = new SymNode(SymKind::FUNC, Storage::GLOBAL);
     symbol->token_ptr = token;
-    symbol->tag.append("F:G:").append(token->val).append(":"); // F:G:name:RET_TPYE:PARAM_TYPES
     this->symtab->Insert(symbol);
+    this->Bind(symbol);
     subTree->symbol_ptr = symbol;
+    this->PushScope(); // 参数和函数体
 
     // 返回值
-    string ret = subTree->child[0]->IsTypeOf(StmtType::RET_INT) ? "I:" : "V:";
+    symbol->rtype = subTree->child[0]->IsTypeOf(StmtType::RET_INT) ? SymType::INT : SymType::VOID;
     // 参数列表
     int v = 0;
-    string params;
+    auto &params = symbol->ptype;
     // 计算参数个数
     int pnums = 0;
     for (auto ptr = subTree->child[1]; ptr != nullptr; ptr = ptr->sibling)
@@ -512,16 +569,16 @@ void SymTable::AddFunc(ASTNodePointer subTree)
         {
             // 参数为void
             v += 1;
-            params.append("V");
+            params.push_back(SymType::VOID);
         }
         else if (ptr->IsTypeOf(StmtType::PARAM_INT))
         {
-            params.append("I");
+            params.push_back(SymType::INT);
             this->AddVar(ptr, symbol, -2 - pnums);
         }
         else if (ptr->IsTypeOf(StmtType::PARAM_ARR))
         {
-            params.append("A");
+            params.push_back(SymType::ARR);
             this->AddArr(ptr, symbol, -2 - pnums);
         }
         else
@@ -536,10 +593,10 @@ void SymTable::AddFunc(ASTNodePointer subTree)
         // Error: 多个void或void和其他类型一起出现
         this->EmitSymError("Wrong Params", subTree->token);
     }
-    symbol->tag.append(ret).append(params);
 
     // 解析函数内部
     this->Build(subTree->child[2], symbol);
+    this->PopScope();
 }
 
 bool SymTable::TypeCheck()
@@ -554,12 +611,40 @@ bool SymTable::TypeCheck()
 
 void SymTable::TypeCheck(ASTNodePointer subTree)
 {
-    if (subTree == nullptr)
-        return;
-    for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+    // 后序遍历，用显式栈代替递归：栈中记录结点和下一个要进入的子结点，
+    // 子结点都检查完后检查结点本身，再以兄弟结点替换栈顶
+    vector<pair<ASTNodePointer, int>> stack;
+    if (subTree != nullptr)
     {
-        TypeCheck(subTree->child[i]);
+        stack.emplace_back(subTree, 0);
     }
+    while (!stack.empty())
+    {
+        auto &top = stack.back();
+        if (top.second < ASTNode::MAXCHILD)
+        {
+            auto child = top.first->child[top.second++];
+            if (child != nullptr)
+            {
+                stack.emplace_back(child, 0);
+            }
+            continue;
+        }
+        auto node = top.first;
+        this->Check(node);
+        if (node->sibling != nullptr)
+        {
+            top = {node->sibling, 0};
+        }
+        else
+        {
+            stack.pop_back();
+        }
+    }
+}
+
+void SymTable::Check(ASTNodePointer subTree)
+{
     switch (subTree->stmtType)
     {
     case StmtType::ASSIGN_STMT:
@@ -610,7 +695,7 @@ void SymTable::TypeCheck(ASTNodePointer subTree)
     {
         // if (subTree->symbol_ptr == nullptr)
         // {
-        //     Logger::Error("Token %s \n", subTree->token.val.c_str());
+        //     Logger::Error("Token %s \n", subTree->token.Text().c_str());
         // }
         if (!subTree->symbol_ptr->IsArr())
         {
@@ -631,45 +716,53 @@ void SymTable::TypeCheck(ASTNodePointer subTree)
     case StmtType::FUNC_CALL:
     {
         auto symbol = subTree->symbol_ptr;
-        subTree->expType = (symbol->GetRType() == "I") ? ExpType::INT : ExpType::VOID;
+        subTree->expType = (symbol->GetRType() == SymType::INT) ? ExpType::INT : ExpType::VOID;
 
-        // 实参类型检查
-        string actual;
-        for (auto ptr = subTree->child[0]; ptr != nullptr; ptr = ptr->sibling)
+        // 实参类型检查，逐个与形参比较；没有实参时与 void 比较
+        auto &ptype = symbol->GetPType();
+        bool match = true;
+        size_t n = 0;
+        for (auto ptr = subTree->child[0]; ptr != nullptr; ptr = ptr->sibling, ++n)
         {
+            SymType actual = SymType::VOID;
             switch (ptr->expType)
             {
             case ExpType::INT:
             case ExpType::NUM:
             {
-                actual.append("I");
+                actual = SymType::INT;
                 break;
             }
             case ExpType::ARR:
             {
-                actual.append("A");
+                actual = SymType::ARR;
                 break;
             }
             case ExpType::VOID:
             {
-                actual.append("V");
+                actual = SymType::VOID;
                 break;
             }
             default:
             {
                 // Error: 意外的类型
-                actual.append("?");
+                match = false;
                 // this->FLAG_TYPECHECK = false;
                 this->EmitTypeError("Unexpected Value Type", subTree->token);
                 break;
             }
             }
+            match = match && n < ptype.size() && ptype[n] == actual;
+        }
+        if (n == 0)
+        {
+            match = ptype.size() == 1 && ptype[0] == SymType::VOID;
         }
-        if (actual.empty())
+        else
         {
-            actual.append("V");
+            match = match && n == ptype.size();
         }
-        if (symbol->GetPType() != actual)
+        if (!match)
         {
             // Error: 参数列表不匹配
             // this->FLAG_TYPECHECK = false;
@@ -698,10 +791,9 @@ void SymTable::TypeCheck(ASTNodePointer subTree)
             break;
         }
         // 返回值类型与声明不匹配
-        // printf(subTree->token.val.c_str());
+        // printf(subTree->token.Text().c_str());
         auto fnode = subTree->symbol_ptr;
-        // printf(fnode->tag.c_str());
-        auto t = fnode->GetRType() == "V" ? ExpType::VOID : ExpType::INT;
+        auto t = fnode->GetRType() == SymType::VOID ? ExpType::VOID : ExpType::INT;
         if ((c0 == nullptr && t != ExpType::VOID) ||
             (c0 != nullptr && t != ExpType::INT))
         {
@@ -723,7 +815,7 @@ void SymTable::TypeCheck(ASTNodePointer subTree)
         {
             // if (subTree->symbol_ptr == nullptr)
             // {
-            //     Logger::Error("Token %s \n", subTree->token.val.c_str());
+            //     Logger::Error("Token %s \n", subTree->token.Text().c_str());
             // }
             subTree->expType = (subTree->symbol_ptr->IsArr()) ? ExpType::ARR : ExpType::INT;
         }
@@ -739,7 +831,6 @@ void SymTable::TypeCheck(ASTNodePointer subTree)
     default:
         break;
     }
-    TypeCheck(subTree->sibling);
 }
 
 void SymTable::EmitSymError(const string &error, Token &tp)
@@ -748,8 +839,8 @@ void SymTable::EmitSymError(const string &error, Token &tp)
     Logger::Error("%.*s: \"%.*s\" at (%d,%d)\n",
                   error.size(),
                   error.data(),
-                  tp.val.size(),
-                  tp.val.data(),
+                  tp.Text().size(),
+                  tp.Text().data(),
                   tp.row,
                   tp.col);
 }
@@ -760,8 +851,8 @@ void SymTable::EmitTypeError(const string &error, Token &tp)
     Logger::Error("%.*s: \"%.*s\" at (%d,%d)\n",
                   error.size(),
                   error.data(),
-                  tp.val.size(),
-                  tp.val.data(),
+                  tp.Text().size(),
+                  tp.Text().data(),
                   tp.row,
                   tp.col);
 }
@@ -769,15 +860,47 @@ void SymTable::EmitTypeError(const string &error, Token &tp)
 void SymTable::InitBuiltIn()
 {
     // int input(void)
-    SymNodePointer f_input = new SymNode("F:G:input:I:V");
+    SymNodePointer f_input = new SymNode(SymKind::FUNC, Storage::GLOBAL);
     static Token t_input(TokenType::ID, "input");
     f_input->token_ptr = &t_input;
+    f_input->builtin = SymNode::INPUT;
+    f_input->rtype = SymType::INT;
+    f_input->ptype = {SymType::VOID};
 
     // void output(int)
-    SymNodePointer f_output = new SymNode("F:G:output:V:I");
+    SymNodePointer f_output = new SymNode(SymKind::FUNC, Storage::GLOBAL);
     static Token t_output(TokenType::ID, "output");
     f_output->token_ptr = &t_output;
+    f_output->builtin = SymNode::OUTPUT;
+    f_output->rtype = SymType::VOID;
+    f_output->ptype = {SymType::INT};
 
     this->symtab->Insert(f_input);
     this->symtab->Insert(f_output);
+    this->Bind(f_input);
+    this->Bind(f_output);
+
+    // 直接翻译为虚拟机指令的内建函数
+    static vector<Token> t_builtin;
+    if (t_builtin.empty())
+    {
+        for (auto &b : BuiltIn::TABLE)
+        {
+            t_builtin.push_back(Token(TokenType::ID, b.name));
+        }
+    }
+    for (size_t i = 0; i < BuiltIn::TABLE.size(); ++i)
+    {
+        auto &b = BuiltIn::TABLE[i];
+        SymNodePointer f = new SymNode(SymKind::FUNC, Storage::GLOBAL);
+        f->token_ptr = &t_builtin[i];
+        f->builtin = i;
+        f->rtype = b.rtype;
+        for (auto c : b.params)
+        {
+            f->ptype.push_back(static_cast<SymType>(c));
+        }
+        this->symtab->Insert(f);
+        this->Bind(f);
+    }
 }
@@ -1,28 +1,59 @@
 #include "Token.h"
 
-const Token Token::KEYWORD_LIST[] = {
-    Token(TokenType::IF, "if"),
-    Token(TokenType::ELSE, "else"),
-    Token(TokenType::RETURN, "return"),
-    Token(TokenType::VOID, "void"),
-    Token(TokenType::INT, "int"),
-    Token(TokenType::WHILE, "while"),
-};
+constexpr int Token::KeywordHash(string_view sv)
+{
+    // 首字符、末字符和长度的组合在6个关键字上没有冲突
+    return (sv[0] + 7 * sv[sv.size() - 1] + static_cast<int>(sv.size())) & (KEYWORD_SLOTS - 1);
+}
 
-const Token Token::SYMBOL_LIST[] = {
-    Token(TokenType::PLUS, "+"),
-    Token(TokenType::MINUS, "-"),
-    Token(TokenType::TIMES, "*"),
-    Token(TokenType::DIVISION, "/"),
-    Token(TokenType::NOT, "!"),
-    Token(TokenType::LT, "<"),
-    Token(TokenType::LE, "<="),
-    Token(TokenType::EQ, "=="),
-    Token(TokenType::NE, "!="),
-    Token(TokenType::GE, ">="),
-    Token(TokenType::GT, ">"),
-    Token(TokenType::ASSIGN, "="),
-};
+constexpr bool Token::CheckKeywordHash()
+{
+    for (int i = 0; i < KEYWORD_SLOTS; ++i)
+    {
+        if (!KEYWORD_HASH[i].empty() && KeywordHash(KEYWORD_HASH[i]) != i)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+constexpr std::array<TokenType, Token::SYMBOL_SLOTS> Token::MakeSymbolTable(bool eq)
+{
+    std::array<TokenType, SYMBOL_SLOTS> table{};
+    for (auto &t : table)
+    {
+        t = TokenType::INVALID;
+    }
+    if (eq)
+    {
+        table['<'] = TokenType::LE;
+        table['='] = TokenType::EQ;
+        table['!'] = TokenType::NE;
+        table['>'] = TokenType::GE;
+        return table;
+    }
+    table['+'] = TokenType::PLUS;
+    table['-'] = TokenType::MINUS;
+    table['*'] = TokenType::TIMES;
+    table['/'] = TokenType::DIVISION;
+    table['!'] = TokenType::NOT;
+    table['<'] = TokenType::LT;
+    table['>'] = TokenType::GT;
+    table['='] = TokenType::ASSIGN;
+    table[','] = TokenType::COMMA;
+    table[';'] = TokenType::SEMI;
+    table['{'] = TokenType::LBRACE;
+    table['}'] = TokenType::RBRACE;
+    table['['] = TokenType::LBRACKET;
+    table[']'] = TokenType::RBRACKET;
+    table['('] = TokenType::LPAREN;
+    table[')'] = TokenType::RPAREN;
+    return table;
+}
+
+const std::array<TokenType, Token::SYMBOL_SLOTS> Token::SYMBOL = Token::MakeSymbolTable(false);
+const std::array<TokenType, Token::SYMBOL_SLOTS> Token::SYMBOL_EQ = Token::MakeSymbolTable(true);
 
 const Token Token::RELOP_LIST[] = {
     Token(TokenType::LT, "<"),
@@ -40,24 +71,6 @@ const Token Token::MATHOP_LIST[] = {
     Token(TokenType::DIVISION, "/"),
 };
 
-const Token Token::PEEK_TOKEN[] = {
-    Token(TokenType::LT, "<"),
-    Token(TokenType::GT, ">"),
-    Token(TokenType::ASSIGN, "="),
-    Token(TokenType::NOT, "!"),
-};
-
-const Token Token::SEPARATE[] = {
-    Token(TokenType::COMMA, ","),
-    Token(TokenType::SEMI, ";"),
-    Token(TokenType::LBRACE, "{"),
-    Token(TokenType::RBRACE, "}"),
-    Token(TokenType::LBRACKET, "["),
-    Token(TokenType::RBRACKET, "]"),
-    Token(TokenType::LPAREN, "("),
-    Token(TokenType::RPAREN, ")"),
-};
-
 map<TokenType, string_view> Token::translation = {
     {TokenType::INVALID, "INVALID"},
     {TokenType::IF, "KEYWORD"},
@@ -91,48 +104,66 @@ map<TokenType, string_view> Token::translation = {
 
 bool Token::IsNeedMore(char c)
 {
-    for (auto token : Token::PEEK_TOKEN)
-    {
-        if (token.val[0] == c)
-        {
-            return true;
-        }
-    }
-    return false;
+    auto i = static_cast<unsigned char>(c);
+    return i < SYMBOL_SLOTS && SYMBOL_EQ[i] != TokenType::INVALID;
 }
 
 TokenType Token::GetSymbolType(string_view sv)
 {
-    for (auto token : Token::SYMBOL_LIST)
+    auto i = sv.empty() ? SYMBOL_SLOTS : static_cast<unsigned char>(sv[0]);
+    if (i >= SYMBOL_SLOTS)
     {
-        if (token.val == sv)
-        {
-            return token.type;
-        }
+        return TokenType::INVALID;
     }
-
-    for (auto token : Token::SEPARATE)
+    if (sv.size() == 1)
     {
-        if (token.val == sv)
-        {
-            return token.type;
-        }
+        return SYMBOL[i];
     }
-
-    return TokenType::INVALID;
+    return (sv.size() == 2 && sv[1] == '=') ? SYMBOL_EQ[i] : TokenType::INVALID;
 }
 
 TokenType Token::GetKeywordType(string_view sv)
 {
-    for (auto token : Token::KEYWORD_LIST)
+    static_assert(CheckKeywordHash(), "keyword hash collision");
+    if (sv.empty())
     {
-        if (token.val == sv)
-        {
-            return token.type;
-        }
+        return TokenType::ID;
+    }
+    int h = KeywordHash(sv);
+    return (KEYWORD_HASH[h] == sv) ? KEYWORD_TYPE[h] : TokenType::ID;
+}
+
+int Token::Intern(string_view sv)
+{
+    auto &ids = Ids();
+    auto iter = ids.find(sv);
+    if (iter != ids.end())
+    {
+        return iter->second;
     }
+    auto &names = Names();
+    names.emplace_back(sv);
+    int id = static_cast<int>(names.size()) - 1;
+    ids.emplace(names.back(), id);
+    return id;
+}
 
-    return TokenType::ID;
+string_view Token::Name(int id)
+{
+    return (id < 0) ? string_view() : string_view(Names()[id]);
+}
+
+std::deque<string> &Token::Names()
+{
+    // 函数内的静态变量，静态初始化的记号也能使用；deque 追加元素时已有元素的地址不变
+    static std::deque<string> names;
+    return names;
+}
+
+std::unordered_map<string_view, int> &Token::Ids()
+{
+    static std::unordered_map<string_view, int> ids;
+    return ids;
 }
 
 string_view Token::GetTokenTranslation(TokenType t)
@@ -150,6 +181,16 @@ bool Token::IsTypeOf(const TokenType &type) const
     return this->type == type;
 }
 
+string_view Token::Text() const
+{
+    return Name(this->id);
+}
+
+long long Token::Value() const
+{
+    return std::stoll(string(this->Text()));
+}
+
 bool Token::IsTypeOfMathOp()
 {
     for (auto &tk : Token::MATHOP_LIST)
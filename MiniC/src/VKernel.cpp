@@ -0,0 +1,225 @@
+#include "VKernel.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+template <int OP>
+int VKernel::Scalar(int x, int y)
+{
+    // 按32位回绕
+    unsigned a = static_cast<unsigned>(x), b = static_cast<unsigned>(y);
+    return static_cast<int>((OP == ADD) ? a + b : (OP == SUB) ? a - b : a * b);
+}
+
+template <int OP>
+void VKernel::Kernel(int *dst, const int *a, const int *b, int n, bool ordered)
+{
+    int i = 0;
+    if (!ordered)
+    {
+#if defined(__AVX2__)
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+            __m256i z = (OP == ADD) ? _mm256_add_epi32(x, y) : (OP == SUB) ? _mm256_sub_epi32(x, y) : _mm256_mullo_epi32(x, y);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), z);
+        }
+#elif defined(__SSE2__)
+        // SSE2 没有32位乘法的低位结果(SSE4.1 才有)，乘法逐个计算
+        for (; OP != MUL && i + 4 <= n; i += 4)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+            __m128i z = (OP == ADD) ? _mm_add_epi32(x, y) : _mm_sub_epi32(x, y);
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), z);
+        }
+#endif
+    }
+    for (; i < n; ++i)
+    {
+        dst[i] = Scalar<OP>(a[i], b[i]);
+    }
+}
+
+void VKernel::Binary(int op, int *dst, const int *a, const int *b, int n)
+{
+    bool ordered = Behind(dst, a, n) || Behind(dst, b, n);
+    switch (op)
+    {
+    case ADD:
+        Kernel<ADD>(dst, a, b, n, ordered);
+        break;
+    case SUB:
+        Kernel<SUB>(dst, a, b, n, ordered);
+        break;
+    default:
+        Kernel<MUL>(dst, a, b, n, ordered);
+        break;
+    }
+}
+
+void VKernel::Fill(int *dst, int v, int n)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i x = _mm256_set1_epi32(v);
+    for (; i + 8 <= n; i += 8)
+    {
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), x);
+    }
+#elif defined(__SSE2__)
+    __m128i x = _mm_set1_epi32(v);
+    for (; i + 4 <= n; i += 4)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), x);
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        dst[i] = v;
+    }
+}
+
+void VKernel::Copy(int *dst, const int *src, int n)
+{
+    if (Behind(dst, src, n))
+    {
+        // 按顺序复制时前面写入的值会被再次读到
+        for (int i = 0; i < n; ++i)
+        {
+            dst[i] = src[i];
+        }
+        return;
+    }
+    // 目标在源之前或不重叠，memmove 的结果与顺序复制相同
+    std::memmove(dst, src, static_cast<size_t>(n) * sizeof(int));
+}
+
+int VKernel::Sum(const int *a, int n)
+{
+    // 回绕的加法满足结合律，分组累加的结果不变
+    int i = 0;
+    unsigned s = 0;
+#if defined(__AVX2__)
+    __m256i acc = _mm256_setzero_si256();
+    for (; i + 8 <= n; i += 8)
+    {
+        acc = _mm256_add_epi32(acc, _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)));
+    }
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+    s = static_cast<unsigned>(_mm_cvtsi128_si32(half));
+#elif defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 4 <= n; i += 4)
+    {
+        acc = _mm_add_epi32(acc, _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0x4E));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, 0xB1));
+    s = static_cast<unsigned>(_mm_cvtsi128_si32(acc));
+#endif
+    for (; i < n; ++i)
+    {
+        s += static_cast<unsigned>(a[i]);
+    }
+    return static_cast<int>(s);
+}
+
+void VKernel::Sort(int *a, int n)
+{
+    std::sort(a, a + n);
+}
+
+int VKernel::Extreme(const int *a, int n, bool max)
+{
+    int i = 0;
+    int r = a[0];
+#if defined(__AVX2__)
+    if (n >= 8)
+    {
+        __m256i acc = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a));
+        for (i = 8; i + 8 <= n; i += 8)
+        {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+            acc = max ? _mm256_max_epi32(acc, x) : _mm256_min_epi32(acc, x);
+        }
+        int lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), acc);
+        r = lanes[0];
+        for (int k = 1; k < 8; ++k)
+        {
+            r = max ? std::max(r, lanes[k]) : std::min(r, lanes[k]);
+        }
+    }
+#elif defined(__SSE2__)
+    // SSE2 没有32位有符号最值指令(SSE4.1 才有)，用比较结果选择
+    if (n >= 4)
+    {
+        __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a));
+        for (i = 4; i + 4 <= n; i += 4)
+        {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+            __m128i take = max ? _mm_cmpgt_epi32(x, acc) : _mm_cmpgt_epi32(acc, x);
+            acc = _mm_or_si128(_mm_and_si128(take, x), _mm_andnot_si128(take, acc));
+        }
+        int lanes[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), acc);
+        r = lanes[0];
+        for (int k = 1; k < 4; ++k)
+        {
+            r = max ? std::max(r, lanes[k]) : std::min(r, lanes[k]);
+        }
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        r = max ? std::max(r, a[i]) : std::min(r, a[i]);
+    }
+    return r;
+}
+
+int VKernel::Find(const int *a, int v, int n)
+{
+    int i = 0;
+#if defined(__AVX2__)
+    __m256i key = _mm256_set1_epi32(v);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i)), key);
+        int mask = _mm256_movemask_ps(_mm256_castsi256_ps(eq));
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#elif defined(__SSE2__)
+    __m128i key = _mm_set1_epi32(v);
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i)), key);
+        int mask = _mm_movemask_ps(_mm_castsi128_ps(eq));
+        if (mask != 0)
+        {
+            return i + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        if (a[i] == v)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool VKernel::Behind(const int *dst, const int *src, int n)
+{
+    return dst > src && dst < src + n;
+}
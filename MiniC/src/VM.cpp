@@ -1,4 +1,5 @@
 #include "VM.h"
+#include "VKernel.h"
 
 const map<string, OPCODE> VM::OPMAP =
     {
@@ -9,6 +10,21 @@ const map<string, OPCODE> VM::OPMAP =
         {"SUB", OPCODE::SUB},
         {"MUL", OPCODE::MUL},
         {"DIV", OPCODE::DIV},
+        {"AND", OPCODE::AND},
+        {"OR", OPCODE::OR},
+        {"XOR", OPCODE::XOR},
+        {"VADD", OPCODE::VADD},
+        {"VSUB", OPCODE::VSUB},
+        {"VMUL", OPCODE::VMUL},
+        {"VFILL", OPCODE::VFILL},
+        {"VCOPY", OPCODE::VCOPY},
+        {"VSUM", OPCODE::VSUM},
+        {"VSORT", OPCODE::VSORT},
+        {"VMIN", OPCODE::VMIN},
+        {"VMAX", OPCODE::VMAX},
+        {"VFIND", OPCODE::VFIND},
+        {"SHL", OPCODE::SHL},
+        {"SHR", OPCODE::SHR},
         {"LD", OPCODE::LD},
         {"LDA", OPCODE::LDA},
         {"LDC", OPCODE::LDC},
@@ -108,7 +124,7 @@ void VM::Run()
 
 VMSTATUS VM::RunInst()
 {
-    int r, s, t, m;
+    int r = 0, s = 0, t = 0, m = 0;
     Instruction &inst = instruction.at(Register[REG_PC]);
     Register[REG_PC] += 1;
     if (inst.op < OPCODE::RRLim)
@@ -137,6 +153,8 @@ VMSTATUS VM::RunInst()
         {
         case -1:
             return VMSTATUS::NegativeArrayOffsetError;
+        case -2:
+            return VMSTATUS::ArrayOffsetRangeError;
         default:
             return VMSTATUS::END;
         }
@@ -177,6 +195,113 @@ VMSTATUS VM::RunInst()
         Register[r] = Register[s] / Register[t];
         break;
     }
+    case OPCODE::AND:
+    {
+        Register[r] = Register[s] & Register[t];
+        break;
+    }
+    case OPCODE::OR:
+    {
+        Register[r] = Register[s] | Register[t];
+        break;
+    }
+    case OPCODE::XOR:
+    {
+        Register[r] = Register[s] ^ Register[t];
+        break;
+    }
+    case OPCODE::VADD:
+    case OPCODE::VSUB:
+    case OPCODE::VMUL:
+    {
+        int n = Register[REG_AC];
+        if (n <= 0)
+        {
+            break;
+        }
+        if (!InRange(Register[r], n) || !InRange(Register[s], n) || !InRange(Register[t], n))
+        {
+            return VMSTATUS::VMError;
+        }
+        int op = (inst.op == OPCODE::VADD) ? VKernel::ADD : (inst.op == OPCODE::VSUB) ? VKernel::SUB : VKernel::MUL;
+        VKernel::Binary(op, dMem + Register[r], dMem + Register[s], dMem + Register[t], n);
+        break;
+    }
+    case OPCODE::VFILL:
+    {
+        int n = Register[REG_AC];
+        if (n <= 0)
+        {
+            break;
+        }
+        if (!InRange(Register[r], n))
+        {
+            return VMSTATUS::VMError;
+        }
+        VKernel::Fill(dMem + Register[r], Register[s], n);
+        break;
+    }
+    case OPCODE::VCOPY:
+    {
+        int n = Register[REG_AC];
+        if (n <= 0)
+        {
+            break;
+        }
+        if (!InRange(Register[r], n) || !InRange(Register[s], n))
+        {
+            return VMSTATUS::VMError;
+        }
+        VKernel::Copy(dMem + Register[r], dMem + Register[s], n);
+        break;
+    }
+    case OPCODE::VSUM:
+    {
+        // 结果可以写回保存长度的 AC
+        int n = Register[REG_AC];
+        if (n > 0 && !InRange(Register[s], n))
+        {
+            return VMSTATUS::VMError;
+        }
+        Register[r] = (n > 0) ? VKernel::Sum(dMem + Register[s], n) : 0;
+        break;
+    }
+    case OPCODE::VSORT:
+    {
+        int n = Register[REG_AC];
+        if (n <= 0)
+        {
+            break;
+        }
+        if (!InRange(Register[r], n))
+        {
+            return VMSTATUS::VMError;
+        }
+        VKernel::Sort(dMem + Register[r], n);
+        break;
+    }
+    case OPCODE::VMIN:
+    case OPCODE::VMAX:
+    {
+        int n = Register[REG_AC];
+        if (n > 0 && !InRange(Register[s], n))
+        {
+            return VMSTATUS::VMError;
+        }
+        bool max = (inst.op == OPCODE::VMAX);
+        Register[r] = (n > 0) ? VKernel::Extreme(dMem + Register[s], n, max) : 0;
+        break;
+    }
+    case OPCODE::VFIND:
+    {
+        int n = Register[REG_AC];
+        if (n > 0 && !InRange(Register[s], n))
+        {
+            return VMSTATUS::VMError;
+        }
+        Register[r] = (n > 0) ? VKernel::Find(dMem + Register[s], Register[t], n) : -1;
+        break;
+    }
     case OPCODE::LD:
     {
         Register[r] = dMem[m];
@@ -198,6 +323,16 @@ VMSTATUS VM::RunInst()
         Register[r] = m;
         break;
     }
+    case OPCODE::SHL:
+    {
+        Register[r] = static_cast<int>(static_cast<unsigned>(Register[s]) << (inst.arg2 & 31));
+        break;
+    }
+    case OPCODE::SHR:
+    {
+        Register[r] = Register[s] >> (inst.arg2 & 31);
+        break;
+    }
     case OPCODE::JLT:
     {
         if (Register[r] < 0)
@@ -275,6 +410,11 @@ void VM::Debug()
     }
 }
 
+bool VM::InRange(int addr, int n)
+{
+    return addr >= 0 && addr <= dm_size && n <= dm_size - addr;
+}
+
 void VM::PrintRegister()
 {
     Logger::Print("(0)AC:%d (1)AC1:%d (2)BP:%d (5)GP:%d (6)FP:%d (7)PC:%d \n",
@@ -312,6 +452,11 @@ void VM::PrintError(VMSTATUS e)
         Logger::Error("NegativeArrayOffsetError: offset is negative");
         break;
     }
+    case VMSTATUS::ArrayOffsetRangeError:
+    {
+        Logger::Error("ArrayOffsetRangeError: offset is out of range");
+        break;
+    }
     case VMSTATUS::ZeroDivisionError:
     {
         Logger::Error("ZeroDivisionError: division by zero");
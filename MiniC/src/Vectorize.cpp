@@ -0,0 +1,307 @@
+#include "Vectorize.h"
+#include "BuiltIn.h"
+
+void Vectorize::Run(AST &ast, SymTable &table)
+{
+    this->vectorized = 0;
+    this->builtins.clear();
+    auto global = table.symtab;
+    for (auto ptr = global->scope; ptr != nullptr && ptr != global; ptr = ptr->next)
+    {
+        if (ptr->IsFunc() && BuiltIn::Find(ptr) != nullptr)
+        {
+            this->builtins[string(ptr->token_ptr->Text())] = ptr;
+        }
+    }
+    for (auto ptr = ast.root; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (ptr->IsTypeOf(StmtType::FUNC_DECL))
+        {
+            this->Visit(ptr->child[2]);
+        }
+    }
+}
+
+void Vectorize::Visit(ASTNodePointer list)
+{
+    for (auto ptr = list; ptr != nullptr; ptr = ptr->sibling)
+    {
+        for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+        {
+            this->Visit(ptr->child[i]);
+        }
+        if (ptr->IsTypeOf(StmtType::ITER_STMT) && this->Rewrite(ptr))
+        {
+            ++this->vectorized;
+        }
+    }
+}
+
+bool Vectorize::Rewrite(ASTNodePointer loop)
+{
+    auto cond = loop->child[0];
+    auto body = loop->child[1];
+    if (cond == nullptr || body == nullptr || !cond->IsTypeOf(StmtType::RELOP) ||
+        !body->IsTypeOf(StmtType::COMP_STMT) || body->child[0] != nullptr)
+    {
+        return false;
+    }
+
+    // 条件为 i < n 或 n > i
+    auto x = cond->child[0];
+    auto n = cond->child[1];
+    if (cond->token.IsTypeOf(TokenType::GT))
+    {
+        std::swap(x, n);
+    }
+    else if (!cond->token.IsTypeOf(TokenType::LT))
+    {
+        return false;
+    }
+    if (x == nullptr || n == nullptr || !x->IsTypeOf(StmtType::VAR_CALL) || x->symbol_ptr == nullptr ||
+        !x->symbol_ptr->IsVar() || x->symbol_ptr->IsGlobal())
+    {
+        return false;
+    }
+    SymNodePointer xs = x->symbol_ptr;
+    if (!n->IsTypeOf(StmtType::NUM) &&
+        !(n->IsTypeOf(StmtType::VAR_CALL) && n->symbol_ptr != nullptr && n->symbol_ptr->IsVar() && n->symbol_ptr != xs))
+    {
+        return false;
+    }
+
+    // 最后一条语句为 i = i + 1，之前的语句都可以向量化
+    auto list = body->child[1];
+    ASTNodePointer last = nullptr;
+    for (auto ptr = list; ptr != nullptr; ptr = ptr->sibling)
+    {
+        last = ptr;
+    }
+    if (last == nullptr || last == list || !last->IsTypeOf(StmtType::ASSIGN_STMT) || !this->IsVar(last->child[0], xs))
+    {
+        return false;
+    }
+    auto inc = last->child[1];
+    if (inc == nullptr || !inc->IsTypeOf(StmtType::ADDOP) || !inc->token.IsTypeOf(TokenType::PLUS) ||
+        inc->child[0] == nullptr || inc->child[1] == nullptr)
+    {
+        return false;
+    }
+    auto one = this->IsVar(inc->child[0], xs) ? inc->child[1] : inc->child[0];
+    if (!this->IsVar(inc->child[0], xs) && !this->IsVar(inc->child[1], xs))
+    {
+        return false;
+    }
+    if (!one->IsTypeOf(StmtType::NUM) || one->token.Text() != "1")
+    {
+        return false;
+    }
+    for (auto ptr = list; ptr != last; ptr = ptr->sibling)
+    {
+        if (!this->Match(ptr, xs, list) || (n->IsTypeOf(StmtType::VAR_CALL) && this->IsVar(ptr->child[0], n->symbol_ptr)))
+        {
+            return false;
+        }
+    }
+
+    // 改写为 if (i < n) { 向量内建函数...; i = n; }
+    ASTNodePointer len = new ASTNode(Token(TokenType::MINUS, "-"), StmtType::ADDOP);
+    len->token.row = loop->token.row;
+    len->token.col = loop->token.col;
+    len->expType = ExpType::INT;
+    len->AddChild(n->Clone());
+    len->AddChild(x->Clone());
+    ASTNodePointer comp = new ASTNode(body->token, StmtType::COMP_STMT);
+    for (auto ptr = list; ptr != last; ptr = ptr->sibling)
+    {
+        auto call = this->Lower(ptr, x, len);
+        if (comp->child[1] == nullptr)
+        {
+            comp->child[1] = call;
+        }
+        else
+        {
+            comp->child[1]->AddSibling(call);
+        }
+    }
+    ASTNodePointer end = new ASTNode(last->token, StmtType::ASSIGN_STMT);
+    end->AddChild(x->Clone());
+    end->AddChild(n->Clone());
+    comp->child[1]->AddSibling(end);
+    loop->stmtType = StmtType::IF_STMT;
+    loop->child[1] = comp;
+    return true;
+}
+
+bool Vectorize::Match(ASTNodePointer stmt, SymNodePointer x, ASTNodePointer list)
+{
+    if (!stmt->IsTypeOf(StmtType::ASSIGN_STMT) || stmt->child[0] == nullptr || stmt->child[1] == nullptr)
+    {
+        return false;
+    }
+    auto left = stmt->child[0];
+    auto right = stmt->child[1];
+
+    // s = s + a[i]，s 只在这条语句中出现
+    if (left->IsTypeOf(StmtType::VAR_CALL))
+    {
+        auto s = left->symbol_ptr;
+        if (s == nullptr || !s->IsVar() || s == x || !right->IsTypeOf(StmtType::ADDOP) ||
+            !right->token.IsTypeOf(TokenType::PLUS) || right->child[0] == nullptr || right->child[1] == nullptr)
+        {
+            return false;
+        }
+        bool form = (this->IsVar(right->child[0], s) && this->IsElem(right->child[1], x)) ||
+                    (this->IsElem(right->child[0], x) && this->IsVar(right->child[1], s));
+        int uses = 0;
+        for (auto ptr = list; ptr != nullptr; ptr = ptr->sibling)
+        {
+            uses += this->Count(ptr, s);
+        }
+        return form && uses == 2;
+    }
+
+    if (!this->IsElem(left, x))
+    {
+        return false;
+    }
+    // c[i] = a[i] op b[i]
+    if ((right->IsTypeOf(StmtType::ADDOP) || (right->IsTypeOf(StmtType::MULOP) && right->token.IsTypeOf(TokenType::TIMES))) &&
+        right->child[0] != nullptr)
+    {
+        return this->IsElem(right->child[0], x) && this->IsElem(right->child[1], x);
+    }
+    // c[i] = a[i]
+    if (this->IsElem(right, x))
+    {
+        return true;
+    }
+    // c[i] = v，v 在循环内不被赋值(被赋值的标量只有i和归约变量)
+    if (right->IsTypeOf(StmtType::NUM))
+    {
+        return true;
+    }
+    if (!right->IsTypeOf(StmtType::VAR_CALL) || right->symbol_ptr == nullptr || !right->symbol_ptr->IsVar() ||
+        right->symbol_ptr == x)
+    {
+        return false;
+    }
+    for (auto ptr = list; ptr != nullptr; ptr = ptr->sibling)
+    {
+        if (ptr->IsTypeOf(StmtType::ASSIGN_STMT) && this->IsVar(ptr->child[0], right->symbol_ptr))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+ASTNodePointer Vectorize::Lower(ASTNodePointer stmt, ASTNodePointer x, ASTNodePointer len)
+{
+    auto left = stmt->child[0];
+    auto right = stmt->child[1];
+    const Token &tk = stmt->token;
+
+    // 实参：数组...，[值]，起始下标，元素个数
+    auto tail = [&]()
+    {
+        ASTNodePointer args = x->Clone();
+        args->AddSibling(len->Clone());
+        return args;
+    };
+
+    if (left->IsTypeOf(StmtType::VAR_CALL))
+    {
+        // s = s + _vsum(a, i, n - i)
+        auto elem = this->IsElem(right->child[0], x->symbol_ptr) ? right->child[0] : right->child[1];
+        ASTNodePointer args = this->MakeArr(tk, elem->symbol_ptr);
+        args->AddSibling(tail());
+        ASTNodePointer sum = new ASTNode(right->token, StmtType::ADDOP);
+        sum->expType = ExpType::INT;
+        sum->AddChild(left->Clone());
+        sum->AddChild(this->MakeCall(tk, "_vsum", args));
+        ASTNodePointer assign = new ASTNode(tk, StmtType::ASSIGN_STMT);
+        assign->AddChild(left->Clone());
+        assign->AddChild(sum);
+        return assign;
+    }
+
+    ASTNodePointer args = this->MakeArr(tk, left->symbol_ptr);
+    string name;
+    if (this->IsElem(right, x->symbol_ptr))
+    {
+        name = "_vcopy";
+        args->AddSibling(this->MakeArr(tk, right->symbol_ptr));
+    }
+    else if (right->IsTypeOf(StmtType::ADDOP) || right->IsTypeOf(StmtType::MULOP))
+    {
+        name = right->token.IsTypeOf(TokenType::PLUS) ? "_vadd" : right->token.IsTypeOf(TokenType::MINUS) ? "_vsub" : "_vmul";
+        args->AddSibling(this->MakeArr(tk, right->child[0]->symbol_ptr));
+        args->AddSibling(this->MakeArr(tk, right->child[1]->symbol_ptr));
+    }
+    else
+    {
+        name = "_vfill";
+        args->AddSibling(right->Clone());
+    }
+    args->AddSibling(tail());
+    return this->MakeCall(tk, name, args);
+}
+
+bool Vectorize::IsElem(ASTNodePointer exp, SymNodePointer x)
+{
+    if (exp == nullptr || !exp->IsTypeOf(StmtType::ARR_CALL) || exp->symbol_ptr == nullptr ||
+        !exp->symbol_ptr->IsArr() || !this->IsVar(exp->child[0], x))
+    {
+        return false;
+    }
+    // 向量指令不做越界检查
+    bool low = this->boundsCheck == IR::BOUNDS_NONE || exp->HasAttr(ASTNode::ATTR_LOW_SAFE);
+    bool high = this->boundsCheck != IR::BOUNDS_FULL || exp->HasAttr(ASTNode::ATTR_HIGH_SAFE);
+    return low && high;
+}
+
+bool Vectorize::IsVar(ASTNodePointer exp, SymNodePointer sym)
+{
+    return exp != nullptr && exp->IsTypeOf(StmtType::VAR_CALL) && exp->symbol_ptr == sym;
+}
+
+int Vectorize::Count(ASTNodePointer subTree, SymNodePointer sym)
+{
+    if (subTree == nullptr)
+    {
+        return 0;
+    }
+    int count = (subTree->symbol_ptr == sym) ? 1 : 0;
+    for (int i = 0; i < ASTNode::MAXCHILD; ++i)
+    {
+        for (auto ptr = subTree->child[i]; ptr != nullptr; ptr = ptr->sibling)
+        {
+            count += this->Count(ptr, sym);
+        }
+    }
+    return count;
+}
+
+ASTNodePointer Vectorize::MakeCall(const Token &tk, const string &name, ASTNodePointer args)
+{
+    Token t(TokenType::ID, name);
+    t.row = tk.row;
+    t.col = tk.col;
+    ASTNodePointer node = new ASTNode(t, StmtType::FUNC_CALL);
+    node->symbol_ptr = this->builtins.at(name);
+    node->expType = BuiltIn::Find(node->symbol_ptr)->HasResult() ? ExpType::INT : ExpType::VOID;
+    node->AddChild(args);
+    return node;
+}
+
+ASTNodePointer Vectorize::MakeArr(const Token &tk, SymNodePointer arr)
+{
+    Token t(TokenType::ID, arr->token_ptr->Text());
+    t.row = tk.row;
+    t.col = tk.col;
+    ASTNodePointer node = new ASTNode(t, StmtType::VAR_CALL);
+    node->symbol_ptr = arr;
+    node->expType = ExpType::ARR;
+    return node;
+}
@@ -3,10 +3,16 @@
 // 引入minic源码
 
 #include <cstdio>
+#include "MiniC/include/Arena.h"
 #include "MiniC/include/Scanner.h"
 #include "MiniC/include/Parser.h"
 #include "MiniC/include/SymTable.h"
 #include "MiniC/include/IR.h"
+#include "MiniC/include/CFG.h"
+#include "MiniC/include/JumpThread.h"
+#include "MiniC/include/Liveness.h"
+#include "MiniC/include/BoundsCheck.h"
+#include "MiniC/include/Vectorize.h"
 
 
 int Minic::Compile(QString& filename)
@@ -17,6 +23,9 @@ int Minic::Compile(QString& filename)
         return -1;
     }
     string fstr = filename.toStdString();
+    // 语法树和符号表在这次编译的内存池中分配，函数返回时整体释放
+    Arena arena;
+    Arena::Scope scope(arena);
 
     // 词法分析
     string tmp = fstr+".token";
@@ -71,7 +80,19 @@ int Minic::Compile(QString& filename)
     file_ptr = fopen(tmp.c_str(),"w");
     Logger::SetIO(file_ptr);
     IR ir;
+    BoundsCheck bc;
+    bc.Run(parser.GetAST());
+    Vectorize vec;
+    vec.Run(parser.GetAST(), table);
     ir.GenIR(parser.GetAST(), table);
+    CFG cfg;
+    cfg.Build(ir);
+    JumpThread jt;
+    jt.Run(cfg, ir);
+    cfg.RemoveUnreachable();
+    Liveness live;
+    live.Run(cfg, ir, table);
+    cfg.Linearize();
     fprintf(file_ptr,ir.ToString().c_str());
     fclose(file_ptr);
     Logger::SetIO(stdout);